@@ -0,0 +1,57 @@
+#include "Allocation_Counter.h"
+
+#ifdef SUDOKU_COUNT_ALLOCATIONS
+
+#include <cstdlib> //malloc(), free()
+#include <new>
+
+/*Look at Allocation_Counter.h for documention*/
+
+//Every form of operator new ends up in one of the two below, and every form of
+//operator delete in the one after them (aligned forms are left to the library)
+
+void* operator new(std::size_t bytes) {
+	++Allocation_Counter::count;
+	if (void *p = std::malloc(bytes ? bytes : 1)) {
+		return p;
+	}
+	throw std::bad_alloc();
+}
+
+
+void* operator new[](std::size_t bytes) {
+	return operator new(bytes);
+}
+
+
+void* operator new(std::size_t bytes, const std::nothrow_t &) noexcept {
+	++Allocation_Counter::count;
+	return std::malloc(bytes ? bytes : 1);
+}
+
+
+void* operator new[](std::size_t bytes, const std::nothrow_t &tag) noexcept {
+	return operator new(bytes, tag);
+}
+
+
+void operator delete(void *p) noexcept {
+	std::free(p);
+}
+
+
+void operator delete[](void *p) noexcept {
+	std::free(p);
+}
+
+
+void operator delete(void *p, std::size_t) noexcept {
+	std::free(p);
+}
+
+
+void operator delete[](void *p, std::size_t) noexcept {
+	std::free(p);
+}
+
+#endif
@@ -0,0 +1,18 @@
+#ifndef ALLOCATION_COUNTER_H
+#define ALLOCATION_COUNTER_H
+
+#include <cstddef>
+
+//Counts the heap allocations made by each thread, so that debug builds and tests can check
+//that code meant to run without allocating (like Sudoku_Solver::solve()) does not.
+//
+//The count only moves when Allocation_Counter.cpp is compiled with SUDOKU_COUNT_ALLOCATIONS
+//defined and linked into the program, replacing the global operator new; otherwise it stays 0
+//and nothing else needs linking.
+namespace Allocation_Counter {
+	//number of operator new calls made by this thread so far
+	inline thread_local size_t count = 0;
+}
+
+
+#endif
@@ -0,0 +1,166 @@
+#include "Batch_Solver.h"
+
+#include <algorithm> //min()
+
+using namespace std;
+
+/*Look at Batch_Solver.h for documention on member functions' constraints and (side-)effects*/
+
+namespace {
+	const unsigned short EMPTY_BOARD[Batch_Solver::CELLS] = {};
+
+	const uint16_t FULL_DOMAIN = (1u << Batch_Solver::SIZE) - 1;
+
+	//EFFECTS: returns x if x holds exactly one value, 0 otherwise
+	//		(written without branches so lane loops vectorize)
+	inline uint16_t single_of(uint16_t x) {
+		return ((x & (x - 1)) == 0) ? x : 0;
+	}
+
+	//EFFECTS: returns the indices of the col, row and box units of cell in unit_solved
+	inline void units_of(size_t cell, size_t &col_unit, size_t &row_unit, size_t &box_unit) {
+		size_t row = cell / Batch_Solver::SIZE;
+		size_t col = cell % Batch_Solver::SIZE;
+		col_unit = col;
+		row_unit = Batch_Solver::SIZE + row;
+		box_unit = 2 * Batch_Solver::SIZE + (row / 3) * 3 + col / 3;
+	}
+}
+
+
+Batch_Solver::Batch_Solver()
+	: solver(3, EMPTY_BOARD) {}
+
+
+size_t Batch_Solver::solve(const unsigned short *vals, size_t count, unsigned short *solutions, bool *solved) {
+	size_t num_solved = 0;
+	for (size_t first = 0; first < count; first += LANES) {
+		size_t batch = min(LANES, count - first);
+		load_lanes(vals + first * CELLS, batch);
+		propagate();
+		for (size_t lane = 0; lane < batch; ++lane) {
+			solved[first + lane] = finish_lane(lane, solutions + (first + lane) * CELLS);
+			if (solved[first + lane]) {
+				++num_solved;
+			}
+		}
+	}
+	return num_solved;
+}
+
+
+void Batch_Solver::load_lanes(const unsigned short *vals, size_t count) {
+	for (size_t cell = 0; cell < CELLS; ++cell) {
+		for (size_t lane = 0; lane < LANES; ++lane) {
+			unsigned short val = (lane < count) ? vals[lane * CELLS + cell] : 0;
+			if (val > SIZE) {
+				throw Value_Error("Batch_Solver::solve", val, SIZE);
+			}
+			candidates[cell][lane] = (val == 0) ? FULL_DOMAIN : (uint16_t) (1u << (val - 1));
+		}
+	}
+	fill(failed, failed + LANES, (uint16_t) 0);
+}
+
+
+void Batch_Solver::propagate() {
+	bool changed = true;
+	while (changed) {
+		//collect the values of filled blocks of every unit,
+		//a value filled twice in one unit fails the board
+		for (size_t unit = 0; unit < 3 * SIZE; ++unit) {
+			fill(unit_solved[unit], unit_solved[unit] + LANES, (uint16_t) 0);
+		}
+		for (size_t cell = 0; cell < CELLS; ++cell) {
+			size_t col_unit, row_unit, box_unit;
+			units_of(cell, col_unit, row_unit, box_unit);
+			uint16_t *col_solved = unit_solved[col_unit];
+			uint16_t *row_solved = unit_solved[row_unit];
+			uint16_t *box_solved = unit_solved[box_unit];
+			const uint16_t *cand = candidates[cell];
+			for (size_t lane = 0; lane < LANES; ++lane) {
+				uint16_t single = single_of(cand[lane]);
+				failed[lane] |= (uint16_t) ((col_solved[lane] | row_solved[lane] | box_solved[lane]) & single);
+				col_solved[lane] |= single;
+				row_solved[lane] |= single;
+				box_solved[lane] |= single;
+			}
+		}
+
+		//remove them from the domains of the other blocks
+		uint16_t diff = 0;
+		for (size_t cell = 0; cell < CELLS; ++cell) {
+			size_t col_unit, row_unit, box_unit;
+			units_of(cell, col_unit, row_unit, box_unit);
+			const uint16_t *col_solved = unit_solved[col_unit];
+			const uint16_t *row_solved = unit_solved[row_unit];
+			const uint16_t *box_solved = unit_solved[box_unit];
+			uint16_t *cand = candidates[cell];
+			for (size_t lane = 0; lane < LANES; ++lane) {
+				uint16_t old = cand[lane];
+				uint16_t reduced = (uint16_t) (old & ~(col_solved[lane] | row_solved[lane] | box_solved[lane]));
+				uint16_t updated = single_of(old) ? old : reduced;
+				failed[lane] |= (updated == 0) ? 1 : 0;
+				diff |= (uint16_t) (old ^ updated);
+				cand[lane] = updated;
+			}
+		}
+		changed = (diff != 0);
+	}
+}
+
+
+bool Batch_Solver::finish_lane(size_t lane, unsigned short *solution) {
+	if (failed[lane]) {
+		++propagated;
+		return false;
+	}
+
+	bool complete = true;
+	for (size_t cell = 0; cell < CELLS; ++cell) {
+		uint16_t cand = candidates[cell][lane];
+		if (single_of(cand)) {
+			solution[cell] = (unsigned short) domain_first(cand);
+		} else {
+			solution[cell] = 0;
+			complete = false;
+		}
+	}
+	if (complete) {
+		++propagated;
+		return true;
+	}
+
+	++searched;
+	bool found = false;
+	try {
+		solver.load(3, solution);
+		found = solver.solve();
+	} catch (Sudoku_Error &) {
+	}
+	nodes += solver.get_node_count();
+	if (!found) {
+		return false;
+	}
+	for (unsigned short row = 0; row < SIZE; ++row) {
+		for (unsigned short col = 0; col < SIZE; ++col) {
+			solution[row * SIZE + col] = solver.get_val(row, col);
+		}
+	}
+	return true;
+}
+
+
+size_t Batch_Solver::get_propagated_count() const {
+	return propagated;
+}
+
+
+size_t Batch_Solver::get_searched_count() const {
+	return searched;
+}
+
+
+size_t Batch_Solver::get_node_count() const {
+	return nodes;
+}
@@ -0,0 +1,87 @@
+#ifndef BATCH_SOLVER_H
+#define BATCH_SOLVER_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "Sudoku_Solver.h"
+
+//Solves many classic 9x9 sudoku at once.
+//
+//Boards are propagated LANES at a time with their candidates stored interleaved
+//(candidates[cell][lane]), so every step of singles elimination is one loop over
+//the lanes that the compiler turns into SIMD instructions (16 x 16 bit lanes fill
+//one AVX2 register, or two SSE registers). Each round removes the values of all
+//filled blocks from their peers in every board together until no board changes.
+//Boards that propagation alone solves (most easy and medium puzzles) never reach
+//the search; the rest are handed, with their singles filled in, to a warm
+//Sudoku_Solver for depth first search.
+class Batch_Solver {
+public:
+	//number of boards propagated together
+	static constexpr size_t LANES = 16;
+	static constexpr unsigned short SIZE = 9;
+	static constexpr size_t CELLS = SIZE * SIZE;
+
+	//EFFECTS: creates a batch solver with an idle search engine
+	Batch_Solver();
+
+	//REQUIRES: vals points to count boards of CELLS values each (row-major, 0 for blank),
+	//			solutions points to count * CELLS writable values,
+	//			solved points to count writable flags
+	//MODIFIES: solutions, solved, propagated, searched, nodes
+	//EFFECTS: solves every board; for board i, solved[i] is true and its solution is
+	//		written to solutions + i * CELLS, or solved[i] is false if it is invalid or
+	//		has no solution (its solution values are then left unspecified)
+	//		returns the number of boards solved
+	//		throws Value_Error() if a value is larger than SIZE
+	size_t solve(const unsigned short *vals, size_t count, unsigned short *solutions, bool *solved);
+
+	//EFFECTS: returns the number of boards finished by propagation alone (solved or
+	//		found unsolvable) since construction
+	size_t get_propagated_count() const;
+
+	//EFFECTS: returns the number of boards handed to the search since construction
+	size_t get_searched_count() const;
+
+	//EFFECTS: returns the number of search nodes visited by the boards handed to the search
+	//		since construction (boards finished by propagation alone visit none)
+	size_t get_node_count() const;
+
+private:
+	//candidates[cell][lane]: bit (val-1) is set if val is still possible at cell of board lane
+	std::uint16_t candidates[CELLS][LANES];
+
+	//unit_solved[unit][lane]: values of filled blocks of a unit (9 cols, 9 rows, 9 boxes)
+	std::uint16_t unit_solved[3 * SIZE][LANES];
+
+	//failed[lane]: non-zero once board lane has an empty domain or a duplicate value
+	std::uint16_t failed[LANES];
+
+	//search engine for boards propagation could not finish
+	Sudoku_Solver solver;
+
+	size_t propagated = 0;
+	size_t searched = 0;
+	size_t nodes = 0;
+
+	//REQUIRES: vals points to count (at most LANES) boards
+	//MODIFIES: candidates, failed
+	//EFFECTS: loads count boards into lanes [0:count), fills the other lanes with empty boards
+	//		throws Value_Error() if a value is larger than SIZE
+	void load_lanes(const unsigned short *vals, size_t count);
+
+	//MODIFIES: candidates, unit_solved, failed
+	//EFFECTS: repeats singles elimination on all lanes until no lane changes
+	void propagate();
+
+	//REQUIRES: solution points to CELLS writable values
+	//MODIFIES: solution, solver, searched, nodes
+	//EFFECTS: writes board lane as far as propagation got (0 for undecided blocks),
+	//		then finishes it with the search if needed
+	//		returns false if board lane has no solution
+	bool finish_lane(size_t lane, unsigned short *solution);
+};
+
+
+#endif
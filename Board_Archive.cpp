@@ -0,0 +1,219 @@
+#include "Board_Archive.h"
+#include "Sudoku.h"
+
+#include <algorithm> //fill()
+#include <cerrno>
+#include <cstring> //memcmp(), strerror()
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace std;
+
+/*Look at Board_Archive.h for documention on member functions' constraints and (side-)effects*/
+
+unsigned char Board_Format::bits_per_cell(unsigned short size) {
+	unsigned char bits = 1;
+	while ((1u << bits) <= size) {
+		++bits;
+	}
+	return bits;
+}
+
+
+size_t Board_Format::board_bytes(unsigned short size) {
+	return ((size_t) size * size * bits_per_cell(size) + 7) / 8;
+}
+
+
+Board_Archive::Board_Archive(const unsigned char *data, size_t len) {
+	if (len < Board_Format::HEADER_BYTES
+		|| memcmp(data, Board_Format::MAGIC, sizeof(Board_Format::MAGIC)) != 0) {
+		throw Archive_Error("not a board archive");
+	} else if (data[4] != 1 && data[4] != Board_Format::VERSION) {
+		throw Archive_Error("unsupported version " + to_string(data[4]));
+	}
+
+	box_rows = data[5];
+	box_cols = (data[4] == 1) ? box_rows : data[7]; //version 1 only had square boxes
+	size = (unsigned short) (box_rows * box_cols);
+	bits = data[6];
+	if (size == 0 || size > Board_Format::MAX_SIZE || bits != Board_Format::bits_per_cell(size)) {
+		throw Archive_Error("corrupt header");
+	}
+	mask = (1u << bits) - 1;
+	board_bytes = Board_Format::board_bytes(size);
+
+	count = 0;
+	for (int i = 7; i >= 0; --i) {
+		count = (count << 8) | data[8 + i];
+	}
+	if (count > (len - Board_Format::HEADER_BYTES) / board_bytes) {
+		throw Archive_Error("truncated, header claims " + to_string(count) + " boards");
+	}
+
+	boards = data + Board_Format::HEADER_BYTES;
+}
+
+
+unsigned short Board_Archive::get_box_rows() const {
+	return box_rows;
+}
+
+
+unsigned short Board_Archive::get_box_cols() const {
+	return box_cols;
+}
+
+
+unsigned short Board_Archive::get_size() const {
+	return size;
+}
+
+
+size_t Board_Archive::get_count() const {
+	return count;
+}
+
+
+void Board_Archive::unpack(size_t index, unsigned short *vals) const {
+	if (index >= count) {
+		throw Archive_Error("board index " + to_string(index) + " out of range");
+	}
+	size_t cells = (size_t) size * size;
+	for (size_t cell = 0; cell < cells; ++cell) {
+		vals[cell] = get_cell(index, cell);
+	}
+}
+
+
+Board_Archive_Writer::Board_Archive_Writer(ostream &os_in, unsigned short small_size)
+	: Board_Archive_Writer(os_in, small_size, small_size) {}
+
+
+Board_Archive_Writer::Board_Archive_Writer(ostream &os_in, unsigned short box_rows_in, unsigned short box_cols_in)
+	: os(os_in), box_rows{box_rows_in}, box_cols{box_cols_in}, count{0} {
+	if (box_rows == 0 || box_cols == 0 || (size_t) box_rows * box_cols > Board_Format::MAX_SIZE) {
+		throw Archive_Error(to_string(box_rows) + "x" + to_string(box_cols) + " boxes not supported");
+	}
+	size = (unsigned short) (box_rows * box_cols);
+	bits = Board_Format::bits_per_cell(size);
+	packed.resize(Board_Format::board_bytes(size));
+
+	header_pos = os.tellp();
+	unsigned char header[Board_Format::HEADER_BYTES] = {};
+	memcpy(header, Board_Format::MAGIC, sizeof(Board_Format::MAGIC));
+	header[4] = Board_Format::VERSION;
+	header[5] = (unsigned char) box_rows;
+	header[6] = (unsigned char) bits;
+	header[7] = (unsigned char) box_cols;
+	os.write((const char *) header, sizeof(header));
+}
+
+
+void Board_Archive_Writer::write(const unsigned short *vals) {
+	fill(packed.begin(), packed.end(), (unsigned char) 0);
+	size_t cells = (size_t) size * size;
+	for (size_t cell = 0; cell < cells; ++cell) {
+		pack_cell(cell, vals[cell]);
+	}
+	os.write((const char *) packed.data(), (streamsize) packed.size());
+	++count;
+}
+
+
+void Board_Archive_Writer::write(const Sudoku &sudoku) {
+	if (sudoku.get_box_rows() != box_rows || sudoku.get_box_cols() != box_cols) {
+		throw Archive_Error("board with " + to_string(sudoku.get_box_rows()) + "x"
+			+ to_string(sudoku.get_box_cols()) + " boxes written to archive of "
+			+ to_string(box_rows) + "x" + to_string(box_cols) + " boxes");
+	}
+	fill(packed.begin(), packed.end(), (unsigned char) 0);
+	size_t cell = 0;
+	for (unsigned short row = 0; row < size; ++row) {
+		for (unsigned short col = 0; col < size; ++col) {
+			pack_cell(cell++, sudoku.get_val(row, col));
+		}
+	}
+	os.write((const char *) packed.data(), (streamsize) packed.size());
+	++count;
+}
+
+
+void Board_Archive_Writer::pack_cell(size_t cell, unsigned short val) {
+	if (val > size) {
+		throw Archive_Error("value " + to_string(val) + " out of range");
+	}
+	size_t bit = cell * bits;
+	unsigned int shifted = (unsigned int) val << (bit % 8);
+	packed[bit / 8] |= (unsigned char) shifted;
+	if ((bit % 8) + bits > 8) {
+		packed[bit / 8 + 1] |= (unsigned char) (shifted >> 8);
+	}
+}
+
+
+void Board_Archive_Writer::finish() {
+	auto end_pos = os.tellp();
+	unsigned char count_bytes[8];
+	for (size_t i = 0; i < 8; ++i) {
+		count_bytes[i] = (unsigned char) (count >> (8 * i));
+	}
+	os.seekp(header_pos + (streamoff) 8);
+	os.write((const char *) count_bytes, sizeof(count_bytes));
+	os.seekp(end_pos);
+	if (!os) {
+		throw Archive_Error("failed to write archive");
+	}
+}
+
+
+size_t Board_Archive_Writer::get_count() const {
+	return count;
+}
+
+
+Mapped_File::Mapped_File(const string &path) {
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		throw Archive_Error("cannot open " + path + ": " + strerror(errno));
+	}
+	struct stat st;
+	if (fstat(fd, &st) < 0) {
+		int err = errno;
+		close(fd);
+		throw Archive_Error("cannot stat " + path + ": " + strerror(err));
+	}
+	len = (size_t) st.st_size;
+	if (len == 0) {
+		close(fd);
+		addr = nullptr;
+		return;
+	}
+	void *mapped = mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+	int err = errno;
+	close(fd); //the mapping stays valid after the descriptor is closed
+	if (mapped == MAP_FAILED) {
+		throw Archive_Error("cannot map " + path + ": " + strerror(err));
+	}
+	addr = (const unsigned char *) mapped;
+}
+
+
+Mapped_File::~Mapped_File() {
+	if (addr != nullptr) {
+		munmap((void *) addr, len);
+	}
+}
+
+
+const unsigned char *Mapped_File::data() const {
+	return addr;
+}
+
+
+size_t Mapped_File::size() const {
+	return len;
+}
@@ -0,0 +1,179 @@
+#ifndef BOARD_ARCHIVE_H
+#define BOARD_ARCHIVE_H
+
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <vector>
+
+class Sudoku;
+
+//Versioned binary format for storing many sudoku boards of the same size.
+//
+//Layout (all integers little-endian):
+//	offset 0:  magic "SDKB"
+//	offset 4:  version (currently 2)
+//	offset 5:  box_rows
+//	offset 6:  bits_per_cell, the fewest bits that hold values [0:size]
+//	           (4 for 9x9, 5 for 16x16 and 25x25, 6 for 36x36)
+//	offset 7:  box_cols (version 1 archives store 0 here and have square boxes)
+//	offset 8:  count, number of boards (64 bits)
+//	offset 16: count boards of board_bytes each
+//
+//Each board packs its size^2 values in row-major order, bits_per_cell bits each,
+//starting from the least significant bit of the first byte. Boards are padded to
+//a whole byte so any board can be read in place without decoding the ones before it.
+namespace Board_Format {
+	const unsigned char MAGIC[4] = {'S', 'D', 'K', 'B'};
+	const unsigned char VERSION = 2;
+	const size_t HEADER_BYTES = 16;
+	//largest size whose values still fit in 8 bits per cell
+	const unsigned short MAX_SIZE = 255;
+
+	//EFFECTS: returns the number of bits needed to store values [0:size]
+	unsigned char bits_per_cell(unsigned short size);
+
+	//EFFECTS: returns the number of bytes one packed size x size board takes
+	size_t board_bytes(unsigned short size);
+}
+
+
+//Read-only view of a board archive held in memory (e.g. a memory-mapped file).
+//Does not copy or own the data; it must outlive the Board_Archive.
+class Board_Archive {
+public:
+	//REQUIRES: data points to len readable bytes
+	//EFFECTS: creates a view of the archive at data
+	//		throws Archive_Error() if the header is invalid or data is too short
+	Board_Archive(const unsigned char *data, size_t len);
+
+	//EFFECTS: returns the number of rows in a box of every board in the archive
+	unsigned short get_box_rows() const;
+
+	//EFFECTS: returns the number of columns in a box of every board in the archive
+	unsigned short get_box_cols() const;
+
+	//EFFECTS: returns size (box_rows*box_cols) of every board in the archive
+	unsigned short get_size() const;
+
+	//EFFECTS: returns the number of boards in the archive
+	size_t get_count() const;
+
+	//REQUIRES: index is smaller than count, cell is smaller than size^2
+	//EFFECTS: returns the value of cell (row*size + col) of board index
+	unsigned short get_cell(size_t index, size_t cell) const {
+		size_t bit = cell * bits;
+		const unsigned char *p = boards + index * board_bytes + bit / 8;
+		//bits <= 8 so a cell never spans more than two bytes
+		unsigned int window = p[0];
+		if ((bit % 8) + bits > 8) {
+			window |= (unsigned int) p[1] << 8;
+		}
+		return (unsigned short) ((window >> (bit % 8)) & mask);
+	}
+
+	//REQUIRES: index is smaller than count, vals points to size^2 writable values
+	//MODIFIES: vals
+	//EFFECTS: unpacks board index into vals in row-major order
+	//		throws Archive_Error() if index is out of range
+	void unpack(size_t index, unsigned short *vals) const;
+
+private:
+	const unsigned char *boards;
+	size_t count;
+	size_t board_bytes;
+	unsigned short box_rows;
+	unsigned short box_cols;
+	unsigned short size;
+	unsigned int bits;
+	unsigned int mask;
+};
+
+
+//Writes boards of one size to an ostream in the board archive format
+class Board_Archive_Writer {
+public:
+	//REQUIRES: os is open in binary mode; os must be seekable for finish()
+	//			to patch the board count into the header
+	//MODIFIES: os
+	//EFFECTS: writes the archive header for boards with square boxes of small_size
+	//		throws Archive_Error() if small_size^2 is 0 or above MAX_SIZE
+	Board_Archive_Writer(std::ostream &os, unsigned short small_size);
+
+	//REQUIRES: same as above
+	//MODIFIES: os
+	//EFFECTS: writes the archive header for boards with box_rows x box_cols boxes
+	//		throws Archive_Error() if box_rows*box_cols is 0 or above MAX_SIZE
+	Board_Archive_Writer(std::ostream &os, unsigned short box_rows, unsigned short box_cols);
+
+	//REQUIRES: vals points to size^2 values in [0:size]
+	//MODIFIES: os, count
+	//EFFECTS: appends one packed board
+	//		throws Archive_Error() if a value is out of range
+	void write(const unsigned short *vals);
+
+	//MODIFIES: os, count
+	//EFFECTS: appends the board of sudoku
+	//		throws Archive_Error() if sudoku does not have this archive's box shape
+	void write(const Sudoku &sudoku);
+
+	//MODIFIES: os
+	//EFFECTS: records the number of boards written in the header
+	//		throws Archive_Error() if os is in a failed state
+	void finish();
+
+	//EFFECTS: returns the number of boards written so far
+	size_t get_count() const;
+
+private:
+	std::ostream &os;
+	std::streampos header_pos;
+	unsigned short box_rows;
+	unsigned short box_cols;
+	unsigned short size;
+	unsigned int bits;
+	size_t count;
+	std::vector<unsigned char> packed; //reused buffer for one board
+
+	//REQUIRES: cell is smaller than size^2, packed holds zeros at cell's bits
+	//MODIFIES: packed
+	//EFFECTS: stores val at cell in packed
+	//		throws Archive_Error() if val is out of range
+	void pack_cell(size_t cell, unsigned short val);
+};
+
+
+//Read-only memory mapping of a whole file, for zero-copy use with Board_Archive
+class Mapped_File {
+public:
+	//EFFECTS: maps the file at path into memory
+	//		throws Archive_Error() if it cannot be opened or mapped
+	Mapped_File(const std::string &path);
+
+	~Mapped_File();
+
+	Mapped_File(const Mapped_File &) = delete;
+	Mapped_File &operator=(const Mapped_File &) = delete;
+
+	//EFFECTS: returns a pointer to the mapped bytes
+	const unsigned char *data() const;
+
+	//EFFECTS: returns the length of the file
+	size_t size() const;
+
+private:
+	const unsigned char *addr;
+	size_t len;
+};
+
+
+//Exception thrown on malformed archives or I/O failure
+class Archive_Error {
+public:
+	Archive_Error(const std::string &msg_in) : msg{"Board archive: " + msg_in + "\n"} {}
+
+	std::string msg;
+};
+
+
+#endif
@@ -0,0 +1,211 @@
+#include "Constraint_Model.h"
+
+#include <algorithm> //find()
+
+using namespace std;
+
+/*Look at Constraint_Model.h for documention on member functions' constraints and (side-)effects*/
+
+Constraint_Model::Constraint_Model() {
+	reset(0, 0);
+}
+
+
+Constraint_Model::Constraint_Model(unsigned short box_rows_in, unsigned short box_cols_in) {
+	reset(box_rows_in, box_cols_in);
+}
+
+
+void Constraint_Model::reset(unsigned short box_rows_in, unsigned short box_cols_in) {
+	box_rows = box_rows_in;
+	box_cols = box_cols_in;
+	size = (unsigned short) (box_rows * box_cols);
+	diagonals = false;
+	regions.clear();
+	cages.clear();
+	cage_index.clear();
+	units.clear();
+	peer_offsets.clear();
+	peer_keys.clear();
+}
+
+
+void Constraint_Model::add_diagonals() {
+	diagonals = true;
+	build();
+}
+
+
+void Constraint_Model::set_regions(const vector<unsigned short> &region_of) {
+	size_t num_blocks = (size_t) size * size;
+	if (region_of.size() != num_blocks) {
+		throw Constraint_Error("jigsaw regions must cover all " + to_string(num_blocks) + " blocks");
+	}
+	vector<unsigned short> region_size(size, 0);
+	for (auto region : region_of) {
+		if (region >= size) {
+			throw Constraint_Error("jigsaw region index " + to_string(region) + " out of range");
+		}
+		++region_size[region];
+	}
+	for (unsigned short region = 0; region < size; ++region) {
+		if (region_size[region] != size) {
+			throw Constraint_Error("jigsaw region " + to_string(region) + " has "
+				+ to_string(region_size[region]) + " blocks instead of " + to_string(size));
+		}
+	}
+	regions = region_of;
+	build();
+}
+
+
+void Constraint_Model::add_cage(unsigned short sum, const vector<unsigned short> &keys) {
+	size_t num_blocks = (size_t) size * size;
+	if (keys.empty() || keys.size() > size) {
+		throw Constraint_Error("a cage must have between 1 and " + to_string(size) + " blocks");
+	}
+	//every key is checked before any is assigned, so a throw leaves the model unchanged
+	for (size_t i = 0; i < keys.size(); ++i) {
+		unsigned short key = keys[i];
+		if (key >= num_blocks) {
+			throw Constraint_Error("cage block " + to_string(key) + " out of range");
+		} else if (find(keys.begin(), keys.begin() + (ptrdiff_t) i, key) != keys.begin() + (ptrdiff_t) i) {
+			throw Constraint_Error("block " + to_string(key) + " is repeated in a cage");
+		} else if (!cage_index.empty() && cage_index[key] != NO_CAGE) {
+			throw Constraint_Error("block " + to_string(key) + " is in more than one cage");
+		}
+	}
+
+	if (cage_index.empty()) {
+		cage_index.assign(num_blocks, NO_CAGE);
+	}
+	for (auto key : keys) {
+		cage_index[key] = (unsigned short) cages.size();
+	}
+	cages.push_back(Cage{sum, keys});
+	build();
+}
+
+
+bool Constraint_Model::is_classic() const {
+	return !diagonals && regions.empty() && cages.empty();
+}
+
+
+unsigned short Constraint_Model::get_size() const {
+	return size;
+}
+
+
+bool Constraint_Model::has_regions() const {
+	return !regions.empty();
+}
+
+
+unsigned short Constraint_Model::get_region(unsigned short key) const {
+	return regions[key];
+}
+
+
+size_t Constraint_Model::get_num_units() const {
+	return units.size();
+}
+
+
+const vector<unsigned short>& Constraint_Model::get_unit(size_t index) const {
+	return units[index];
+}
+
+
+size_t Constraint_Model::get_num_cages() const {
+	return cages.size();
+}
+
+
+const Cage& Constraint_Model::get_cage(size_t index) const {
+	return cages[index];
+}
+
+
+void Constraint_Model::build() {
+	units.clear();
+
+	//columns, rows, then boxes or regions: units are listed in this order so each block's
+	//peers come out in the same order the classic row/col/box loops visit them
+	for (unsigned short col = 0; col < size; ++col) {
+		vector<unsigned short> unit;
+		for (unsigned short row = 0; row < size; ++row) {
+			unit.push_back((unsigned short) (row*size + col));
+		}
+		units.push_back(unit);
+	}
+	for (unsigned short row = 0; row < size; ++row) {
+		vector<unsigned short> unit;
+		for (unsigned short col = 0; col < size; ++col) {
+			unit.push_back((unsigned short) (row*size + col));
+		}
+		units.push_back(unit);
+	}
+	if (regions.empty()) {
+		for (unsigned short index = 0; index < size; ++index) {
+			vector<unsigned short> unit;
+			//there are box_rows boxes across each band of box_rows rows
+			unsigned short start_row = (unsigned short) ((index/box_rows)*box_rows);
+			unsigned short start_col = (unsigned short) ((index%box_rows)*box_cols);
+			for (unsigned short row = start_row; row < start_row + box_rows; ++row) {
+				for (unsigned short col = start_col; col < start_col + box_cols; ++col) {
+					unit.push_back((unsigned short) (row*size + col));
+				}
+			}
+			units.push_back(unit);
+		}
+	} else {
+		size_t first_region = units.size();
+		units.resize(first_region + size);
+		for (unsigned short key = 0; key < size*size; ++key) {
+			units[first_region + regions[key]].push_back(key);
+		}
+	}
+	if (diagonals) {
+		vector<unsigned short> main_diagonal, anti_diagonal;
+		for (unsigned short i = 0; i < size; ++i) {
+			main_diagonal.push_back((unsigned short) (i*size + i));
+			anti_diagonal.push_back((unsigned short) (i*size + (size-1-i)));
+		}
+		units.push_back(main_diagonal);
+		units.push_back(anti_diagonal);
+	}
+	for (auto &cage : cages) {
+		units.push_back(cage.keys);
+	}
+
+	//collect each block's peers across all units it belongs to, without repeats
+	size_t num_blocks = (size_t) size * size;
+	vector<vector<unsigned short> > units_of(num_blocks);
+	for (size_t i = 0; i < units.size(); ++i) {
+		for (auto key : units[i]) {
+			units_of[key].push_back((unsigned short) i);
+		}
+	}
+
+	peer_offsets.assign(num_blocks + 1, 0);
+	peer_keys.clear();
+	vector<bool> seen(num_blocks, false);
+	for (size_t key = 0; key < num_blocks; ++key) {
+		seen[key] = true;
+		for (auto unit : units_of[key]) {
+			for (auto other : units[unit]) {
+				if (!seen[other]) {
+					seen[other] = true;
+					peer_keys.push_back(other);
+				}
+			}
+		}
+		//clear marks for the next block
+		seen[key] = false;
+		for (size_t i = peer_offsets[key]; i < peer_keys.size(); ++i) {
+			seen[peer_keys[i]] = false;
+		}
+		peer_offsets[key + 1] = (unsigned int) peer_keys.size();
+	}
+}
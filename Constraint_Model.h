@@ -0,0 +1,136 @@
+#ifndef CONSTRAINT_MODEL_H
+#define CONSTRAINT_MODEL_H
+
+#include <vector>
+#include <string>
+
+//A killer cage: its blocks must all hold different values that add up to sum
+struct Cage {
+	unsigned short sum;
+	std::vector<unsigned short> keys; //keys of the blocks in the cage
+};
+
+//The rules of a sudoku board, declared as data.
+//
+//A unit is a group of blocks that must all hold different values. Every board has
+//its rows, columns and boxes as units; variants add more:
+//	- X-sudoku adds the two main diagonals,
+//	- jigsaw sudoku replaces the boxes with irregular regions,
+//	- killer sudoku adds cages, units whose values must also add up to a given sum.
+//
+//A classic board (rows, columns and rectangular boxes only) keeps no tables at all:
+//Sudoku and Sudoku_Solver handle it with their hard-coded row/col/box loops.
+//Any variant makes the model build its unit list and a peer table (for every block,
+//the keys of all other blocks sharing a unit with it), which drive the generic paths.
+class Constraint_Model {
+public:
+	//EFFECTS: creates an empty model for a 0x0 board
+	Constraint_Model();
+
+	//EFFECTS: creates the classic model of a board with box_rows x box_cols boxes
+	Constraint_Model(unsigned short box_rows, unsigned short box_cols);
+
+	//MODIFIES: all members
+	//EFFECTS: turns the model back into the classic model of a board with
+	//		box_rows x box_cols boxes, keeping allocated storage
+	void reset(unsigned short box_rows, unsigned short box_cols);
+
+	//MODIFIES: diagonals, units, peers
+	//EFFECTS: adds the two main diagonals as units (X-sudoku)
+	void add_diagonals();
+
+	//REQUIRES: region_of has size^2 entries
+	//MODIFIES: regions, units, peers
+	//EFFECTS: replaces the boxes with irregular regions (jigsaw sudoku),
+	//		where region_of[key] is the region index of block key
+	//		throws Constraint_Error() unless there are size regions of size blocks each
+	void set_regions(const std::vector<unsigned short> &region_of);
+
+	//MODIFIES: cages, units, peers
+	//EFFECTS: adds a killer cage over the blocks with the given keys
+	//		throws Constraint_Error() if a key is out of range, repeated,
+	//		already in another cage, or if the cage has more blocks than size
+	void add_cage(unsigned short sum, const std::vector<unsigned short> &keys);
+
+	//EFFECTS: returns true iff the model only has rows, columns and rectangular boxes
+	bool is_classic() const;
+
+	//EFFECTS: returns the dimension of the board
+	unsigned short get_size() const;
+
+	//EFFECTS: returns true iff the boxes were replaced by irregular regions
+	bool has_regions() const;
+
+	//REQUIRES: key is smaller than size^2, has_regions()
+	//EFFECTS: returns the region index of block key
+	unsigned short get_region(unsigned short key) const;
+
+	//EFFECTS: returns the number of units (0 for a classic model)
+	size_t get_num_units() const;
+
+	//REQUIRES: index is smaller than get_num_units()
+	//EFFECTS: returns the keys of the blocks in unit index
+	const std::vector<unsigned short>& get_unit(size_t index) const;
+
+	//REQUIRES: key is smaller than size^2, !is_classic()
+	//EFFECTS: returns a pointer to the first peer of block key
+	//		peers are listed column first, then row, then box or region, then any other unit,
+	//		which is the order the classic loops visit them in
+	const unsigned short* peers_begin(unsigned short key) const {
+		return peer_keys.data() + peer_offsets[key];
+	}
+
+	//REQUIRES: key is smaller than size^2, !is_classic()
+	//EFFECTS: returns a pointer one past the last peer of block key
+	const unsigned short* peers_end(unsigned short key) const {
+		return peer_keys.data() + peer_offsets[key + 1];
+	}
+
+	//EFFECTS: returns the number of killer cages
+	size_t get_num_cages() const;
+
+	//REQUIRES: index is smaller than get_num_cages()
+	//EFFECTS: returns killer cage index
+	const Cage& get_cage(size_t index) const;
+
+	//REQUIRES: key is smaller than size^2
+	//EFFECTS: returns the index of the cage block key is in, or NO_CAGE
+	unsigned short cage_of(unsigned short key) const {
+		return cage_index.empty() ? NO_CAGE : cage_index[key];
+	}
+
+	static constexpr unsigned short NO_CAGE = 0xFFFF;
+
+private:
+	unsigned short box_rows;
+	unsigned short box_cols;
+	unsigned short size;
+
+	bool diagonals;
+	//region_of[key] for jigsaw boards, empty when the boxes are used
+	std::vector<unsigned short> regions;
+	std::vector<Cage> cages;
+	//cage_index[key]: cage of block key or NO_CAGE, empty when there are no cages
+	std::vector<unsigned short> cage_index;
+
+	//units and peer table, only built for variant models
+	std::vector<std::vector<unsigned short> > units;
+	std::vector<unsigned int> peer_offsets;
+	std::vector<unsigned short> peer_keys;
+
+	//MODIFIES: units, peer_offsets, peer_keys
+	//EFFECTS: regenerates the units and the peer table from the declared rules
+	void build();
+};
+
+
+//Exception thrown when a variant rule is malformed
+class Constraint_Error {
+public:
+	Constraint_Error(const std::string &msg_in) : msg{"Invalid sudoku rules: " + msg_in + "\n"} {}
+
+	std::string msg;
+};
+
+
+#endif
@@ -0,0 +1,194 @@
+#include "Search_Recorder.h"
+
+#include <cstring> //memcmp()
+
+using namespace std;
+
+/*Look at Search_Recorder.h for documention on member functions' constraints and (side-)effects*/
+
+namespace {
+	//MODIFIES: out
+	//EFFECTS: appends the bytes of val to out, least significant first
+	void put(vector<unsigned char> &out, uint64_t val, size_t bytes) {
+		for (size_t i = 0; i < bytes; ++i) {
+			out.push_back((unsigned char) (val >> (8 * i)));
+		}
+	}
+
+	//REQUIRES: p points to bytes readable bytes
+	//EFFECTS: returns the little-endian integer at p
+	uint64_t get(const unsigned char *p, size_t bytes) {
+		uint64_t val = 0;
+		for (size_t i = bytes; i > 0; --i) {
+			val = (val << 8) | p[i - 1];
+		}
+		return val;
+	}
+}
+
+
+Search_Recorder::Search_Recorder(size_t max_bytes_in, unsigned short max_depth_in)
+	: max_bytes{max_bytes_in}, max_depth{max_depth_in} {}
+
+
+void Search_Recorder::begin(unsigned short box_rows_in, unsigned short box_cols_in) {
+	box_rows = box_rows_in;
+	box_cols = box_cols_in;
+	truncated = false;
+	open = 0;
+	fail_depth = fail_row = fail_col = 0;
+	records.clear();
+}
+
+
+bool Search_Recorder::enter(size_t depth) {
+	if (depth > max_depth) {
+		return false;
+	} else if (records.size() + (open + 1) * Tree_Format::NODE_BYTES > max_bytes) {
+		truncated = true;
+		return false;
+	}
+	++open;
+	return true;
+}
+
+
+void Search_Recorder::leave(const Node_Record &record) {
+	--open;
+	records.push_back(Tree_Format::NODE);
+	put(records, (uint64_t) record.outcome, 1);
+	put(records, record.depth, 2);
+	put(records, record.row, 1);
+	put(records, record.col, 1);
+	put(records, record.domain_size, 1);
+	put(records, record.children, 1);
+	put(records, record.values_tried, 8);
+	put(records, record.subtree_nodes, 8);
+}
+
+
+void Search_Recorder::fail(size_t depth, unsigned short row, unsigned short col) {
+	fail_depth = (unsigned short) depth;
+	fail_row = row;
+	fail_col = col;
+}
+
+
+void Search_Recorder::land(size_t depth, unsigned short row, unsigned short col) {
+	if (depth > max_depth) {
+		return;
+	} else if (records.size() + open * Tree_Format::NODE_BYTES + Tree_Format::JUMP_BYTES > max_bytes) {
+		truncated = true;
+		return;
+	}
+	records.push_back(Tree_Format::JUMP);
+	records.push_back(0);
+	put(records, fail_depth, 2);
+	put(records, depth, 2);
+	put(records, fail_row, 1);
+	put(records, fail_col, 1);
+	put(records, row, 1);
+	put(records, col, 1);
+}
+
+
+size_t Search_Recorder::get_bytes() const {
+	return records.size();
+}
+
+
+bool Search_Recorder::is_truncated() const {
+	return truncated;
+}
+
+
+void Search_Recorder::write(ostream &os) const {
+	unsigned char header[Tree_Format::HEADER_BYTES] = {};
+	memcpy(header, Tree_Format::MAGIC, sizeof(Tree_Format::MAGIC));
+	header[4] = Tree_Format::VERSION;
+	header[5] = (unsigned char) box_rows;
+	header[6] = (unsigned char) box_cols;
+	header[7] = (unsigned char) ((truncated ? Tree_Format::TRUNCATED : 0)
+								| (open != 0 ? Tree_Format::INCOMPLETE : 0));
+	os.write((const char *) header, sizeof(header));
+	os.write((const char *) records.data(), (streamsize) records.size());
+	if (!os) {
+		throw Record_Error("failed to write search tree");
+	}
+}
+
+
+Search_Tree::Search_Tree(const unsigned char *data, size_t len) {
+	if (len < Tree_Format::HEADER_BYTES
+		|| memcmp(data, Tree_Format::MAGIC, sizeof(Tree_Format::MAGIC)) != 0) {
+		throw Record_Error("not a search tree dump");
+	} else if (data[4] != Tree_Format::VERSION) {
+		throw Record_Error("unsupported version " + to_string(data[4]));
+	}
+	box_rows = data[5];
+	box_cols = data[6];
+	flags = data[7];
+
+	size_t pos = Tree_Format::HEADER_BYTES;
+	while (pos < len) {
+		const unsigned char *p = data + pos;
+		if (p[0] == Tree_Format::NODE && len - pos >= Tree_Format::NODE_BYTES) {
+			if (p[1] < (unsigned char) Node_Outcome::SOLVED || p[1] > (unsigned char) Node_Outcome::SKIPPED) {
+				throw Record_Error("bad node outcome at byte " + to_string(pos));
+			}
+			Node_Record node;
+			node.outcome = (Node_Outcome) p[1];
+			node.depth = (unsigned short) get(p + 2, 2);
+			node.row = p[4];
+			node.col = p[5];
+			node.domain_size = p[6];
+			node.children = p[7];
+			node.values_tried = get(p + 8, 8);
+			node.subtree_nodes = get(p + 16, 8);
+			nodes.push_back(node);
+			pos += Tree_Format::NODE_BYTES;
+		} else if (p[0] == Tree_Format::JUMP && len - pos >= Tree_Format::JUMP_BYTES) {
+			Jump_Record jump;
+			jump.from_depth = (unsigned short) get(p + 2, 2);
+			jump.to_depth = (unsigned short) get(p + 4, 2);
+			jump.from_row = p[6];
+			jump.from_col = p[7];
+			jump.to_row = p[8];
+			jump.to_col = p[9];
+			jumps.push_back(jump);
+			pos += Tree_Format::JUMP_BYTES;
+		} else {
+			throw Record_Error("bad or truncated record at byte " + to_string(pos));
+		}
+	}
+}
+
+
+unsigned short Search_Tree::get_box_rows() const {
+	return box_rows;
+}
+
+
+unsigned short Search_Tree::get_box_cols() const {
+	return box_cols;
+}
+
+
+bool Search_Tree::is_truncated() const {
+	return (flags & Tree_Format::TRUNCATED) != 0;
+}
+
+
+bool Search_Tree::is_incomplete() const {
+	return (flags & Tree_Format::INCOMPLETE) != 0;
+}
+
+
+const vector<Node_Record>& Search_Tree::get_nodes() const {
+	return nodes;
+}
+
+
+const vector<Jump_Record>& Search_Tree::get_jumps() const {
+	return jumps;
+}
@@ -0,0 +1,195 @@
+#ifndef SEARCH_RECORDER_H
+#define SEARCH_RECORDER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Sudoku.h" //Domain_Mask
+
+//Binary dump of the search tree Sudoku_Solver::solve() explores, for finding out where
+//a slow solve spends its time.
+//
+//Layout (all integers little-endian):
+//	offset 0: magic "SDKT"
+//	offset 4: version (currently 1)
+//	offset 5: box_rows
+//	offset 6: box_cols
+//	offset 7: flags, TRUNCATED if nodes or jumps were left out to stay under the size cap,
+//	          INCOMPLETE if the solve was cut short (e.g. by a timeout) with nodes still open
+//	offset 8: records, each starting with its kind
+//
+//Node record (NODE_BYTES), written when the search leaves the node, so children come
+//before their parent (post-order):
+//	kind (1), outcome (1), depth (2), row (1), col (1), domain size when picked (1),
+//	number of children searched (1), mask of values tried (8), nodes in the subtree
+//	including the node itself (8)
+//Jump record (JUMP_BYTES), written when a failure backjumps to a node that then
+//tries its next value:
+//	kind (1), unused (1), depth failed at (2), depth jumped to (2),
+//	row and col failed at (1 each), row and col jumped to (1 each)
+namespace Tree_Format {
+	const unsigned char MAGIC[4] = {'S', 'D', 'K', 'T'};
+	const unsigned char VERSION = 1;
+	const size_t HEADER_BYTES = 8;
+	const size_t NODE_BYTES = 24;
+	const size_t JUMP_BYTES = 10;
+
+	const unsigned char NODE = 1;
+	const unsigned char JUMP = 2;
+
+	const unsigned char TRUNCATED = 1;
+	const unsigned char INCOMPLETE = 2;
+}
+
+
+//How the search left a node
+enum class Node_Outcome : unsigned char {
+	SOLVED = 1,	//the board was filled below this node
+	DEAD_END,	//the picked block had no values left (a failure starts here)
+	EXHAUSTED,	//every value of the picked block failed (a failure starts here)
+	SKIPPED		//a failure below did not involve this block, so it was jumped over
+};
+
+
+//One node of the search tree
+struct Node_Record {
+	Node_Outcome outcome = Node_Outcome::SOLVED;
+	unsigned short depth = 0;
+	//block picked by the node (for DEAD_END, the block with no values left)
+	unsigned short row = 0;
+	unsigned short col = 0;
+	//values the block could take when picked (0 for DEAD_END)
+	unsigned short domain_size = 0;
+	//number of values that led to a deeper node
+	unsigned short children = 0;
+	//bit val-1 is set for each value the block was given
+	Domain_Mask values_tried = 0;
+	uint64_t subtree_nodes = 0;
+};
+
+
+//One backjump, from the node where a failure started to the node that caught it
+struct Jump_Record {
+	unsigned short from_depth = 0;
+	unsigned short to_depth = 0;
+	unsigned short from_row = 0;
+	unsigned short from_col = 0;
+	unsigned short to_row = 0;
+	unsigned short to_col = 0;
+};
+
+
+//Collects the search tree of one solve in memory, up to a size and depth cap.
+//Give it to Sudoku_Solver::set_recorder() and call write() once solve() returns.
+//
+//Nodes deeper than the depth cap are not recorded, but still count in the subtree
+//sizes of the nodes above them. The size cap keeps a prefix of the tree: room for the
+//record of every open node is reserved when it is entered, so every recorded node's
+//ancestors are recorded too.
+class Search_Recorder {
+public:
+	static constexpr size_t DEFAULT_MAX_BYTES = size_t(64) << 20;
+	static constexpr unsigned short NO_DEPTH_LIMIT = 0xFFFF;
+
+	//EFFECTS: creates a recorder keeping at most max_bytes of records (header excluded)
+	//		and only nodes at depth max_depth or shallower (the first search node is depth 0)
+	Search_Recorder(size_t max_bytes = DEFAULT_MAX_BYTES, unsigned short max_depth = NO_DEPTH_LIMIT);
+
+	//MODIFIES: records, flags
+	//EFFECTS: drops the records kept so far and starts recording a solve of a board
+	//		with box_rows x box_cols boxes
+	void begin(unsigned short box_rows, unsigned short box_cols);
+
+	//MODIFIES: open nodes, flags
+	//EFFECTS: returns true if a node entered at depth is recorded, reserving room for its
+	//		record; returns false if it is below the depth cap or there is no room left
+	bool enter(size_t depth);
+
+	//REQUIRES: record is for a node enter() returned true for, and every node entered
+	//			after it has been left
+	//MODIFIES: records, open nodes
+	//EFFECTS: stores the record of a node the search is leaving
+	void leave(const Node_Record &record);
+
+	//MODIFIES: failure
+	//EFFECTS: notes that a failure starts at block (row, col) at depth
+	void fail(size_t depth, unsigned short row, unsigned short col);
+
+	//MODIFIES: records, flags
+	//EFFECTS: records a jump from the last failure to block (row, col) at depth,
+	//		if depth is within the depth cap and there is room for it
+	void land(size_t depth, unsigned short row, unsigned short col);
+
+	//EFFECTS: returns the bytes of records kept so far
+	size_t get_bytes() const;
+
+	//EFFECTS: returns true if records were left out to stay under the size cap
+	bool is_truncated() const;
+
+	//MODIFIES: os
+	//EFFECTS: writes the header and the records kept so far
+	//		throws Record_Error() if os is in a failed state afterwards
+	void write(std::ostream &os) const;
+
+private:
+	size_t max_bytes;
+	unsigned short max_depth;
+	unsigned short box_rows = 0;
+	unsigned short box_cols = 0;
+	bool truncated = false;
+	//recorded nodes entered but not left yet
+	size_t open = 0;
+	//where the last failure started
+	unsigned short fail_depth = 0;
+	unsigned short fail_row = 0;
+	unsigned short fail_col = 0;
+
+	std::vector<unsigned char> records;
+};
+
+
+//Read-only view of a search tree dump held in memory (e.g. a memory-mapped file).
+//Does not copy or own the data; it must outlive the Search_Tree.
+class Search_Tree {
+public:
+	//REQUIRES: data points to len readable bytes
+	//EFFECTS: parses the dump at data
+	//		throws Record_Error() if the header is invalid or a record is malformed
+	Search_Tree(const unsigned char *data, size_t len);
+
+	//EFFECTS: returns the box shape of the board that was solved
+	unsigned short get_box_rows() const;
+	unsigned short get_box_cols() const;
+
+	//EFFECTS: returns the flags of the dump (see Tree_Format)
+	bool is_truncated() const;
+	bool is_incomplete() const;
+
+	//EFFECTS: returns the node records in the order they were written (post-order)
+	const std::vector<Node_Record>& get_nodes() const;
+
+	//EFFECTS: returns the jump records in the order they were written
+	const std::vector<Jump_Record>& get_jumps() const;
+
+private:
+	unsigned short box_rows;
+	unsigned short box_cols;
+	unsigned char flags;
+	std::vector<Node_Record> nodes;
+	std::vector<Jump_Record> jumps;
+};
+
+
+//Exception thrown on a malformed search tree dump or a failed write
+class Record_Error {
+public:
+	Record_Error(const std::string &msg_in) : msg{"Search tree: " + msg_in + "\n"} {}
+
+	std::string msg;
+};
+
+
+#endif
@@ -0,0 +1,591 @@
+#include "Solution_Cache.h"
+#include "Sudoku.h"
+#include "Board_Archive.h" //Mapped_File
+#include "Solution_Checker.h"
+
+#include <algorithm> //sort(), stable_sort(), next_permutation(), lexicographical_compare(), equal()
+#include <cstdio> //rename()
+#include <cstring> //memcmp()
+#include <unistd.h> //truncate()
+
+using namespace std;
+
+/*Look at Solution_Cache.h for documention on member functions' constraints and (side-)effects*/
+
+namespace {
+	const unsigned char CACHE_MAGIC[4] = {'S', 'D', 'K', 'C'};
+	const unsigned char CACHE_VERSION = 1;
+	const size_t CACHE_HEADER_BYTES = 8;
+	//largest board a cache entry can hold, the largest board a Sudoku can hold
+	const size_t MAX_ENTRY_SIZE = 64;
+
+	//REQUIRES: data points to 2 + 2 * num_blocks bytes, num_blocks is the square of
+	//			the product of the first two
+	//EFFECTS: returns true iff the bytes are a cache entry of a board of at most
+	//			MAX_ENTRY_SIZE with values in [0:size] and solution values in [1:size]
+	bool valid_entry(const unsigned char *data, size_t num_blocks) {
+		size_t size = (size_t) data[0] * data[1];
+		if (size > MAX_ENTRY_SIZE) {
+			return false;
+		}
+		for (size_t i = 2; i < 2 + num_blocks; ++i) {
+			if (data[i] > size) {
+				return false;
+			}
+		}
+		for (size_t i = 2 + num_blocks; i < 2 + 2 * num_blocks; ++i) {
+			if (data[i] == 0 || data[i] > size) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	//a line (row or col) is keyed by the sorted (count of givens in the crossing line,
+	//number of times the value appears on the board) of each of its givens,
+	//neither of which changes under the symmetries
+	typedef vector<unsigned int> Line_Key;
+	//a band or stack is keyed by the sorted keys of its lines (pointing into the line keys)
+	typedef vector<const Line_Key*> Group_Key;
+
+	//EFFECTS: returns true iff the line keys of a are lexicographically smaller than those of b
+	bool key_less(const Group_Key &a, const Group_Key &b) {
+		return lexicographical_compare(a.begin(), a.end(), b.begin(), b.end(),
+			[](const Line_Key *x, const Line_Key *y) { return *x < *y; });
+	}
+
+	//EFFECTS: returns true iff the line keys of a equal those of b
+	bool key_equal(const Group_Key &a, const Group_Key &b) {
+		return equal(a.begin(), a.end(), b.begin(), b.end(),
+			[](const Line_Key *x, const Line_Key *y) { return *x == *y; });
+	}
+
+	//REQUIRES: items is sorted by key, same_key(a, b) is true iff items a and b have equal keys
+	//MODIFIES: orders
+	//EFFECTS: appends every order of items that keeps them sorted by key (i.e. that only
+	//		permutes items with equal keys) to orders, one after the other, stopping once
+	//		orders holds limit orders
+	template <typename Key_Equal>
+	void tied_orders(vector<unsigned short> items, Key_Equal same_key, size_t limit, vector<unsigned short> &orders) {
+		//ranges [begin, end) of items with equal keys
+		vector<pair<size_t, size_t> > ties;
+		for (size_t begin = 0; begin < items.size(); ) {
+			size_t end = begin + 1;
+			while (end < items.size() && same_key(items[end], items[begin])) {
+				++end;
+			}
+			if (end - begin > 1) {
+				ties.push_back(make_pair(begin, end));
+			}
+			begin = end;
+		}
+
+		//odometer over the permutations of each tied range, last range fastest
+		while (orders.size() < limit * items.size()) {
+			orders.insert(orders.end(), items.begin(), items.end());
+			size_t k = ties.size();
+			while (k > 0) {
+				--k;
+				auto first = items.begin() + (long) ties[k].first;
+				auto last = items.begin() + (long) ties[k].second;
+				if (next_permutation(first, last)) {
+					break;
+				}
+				//next_permutation wrapped the range back to ascending order, carry on
+				if (k == 0) {
+					return;
+				}
+			}
+			if (ties.empty()) {
+				return;
+			}
+		}
+	}
+
+	//MODIFIES: orders
+	//EFFECTS: replaces orders with the candidate orders of size lines split into num_groups
+	//		groups of group_size consecutive lines, one after the other: groups sorted by
+	//		group key and lines within each group sorted by line key, with equal keys in
+	//		every order, at most limit orders; returns the number of orders
+	//		(consecutive orders share their first lines as far as possible)
+	size_t line_orders(const vector<Line_Key> &line_key, unsigned short num_groups,
+						unsigned short group_size, size_t limit, vector<unsigned short> &orders) {
+		vector<Group_Key> group_key(num_groups);
+		vector<vector<unsigned short> > inner(num_groups);
+		for (unsigned short group = 0; group < num_groups; ++group) {
+			vector<unsigned short> lines;
+			for (unsigned short i = 0; i < group_size; ++i) {
+				unsigned short line = (unsigned short) (group * group_size + i);
+				lines.push_back(line);
+				group_key[group].push_back(&line_key[line]);
+			}
+			sort(group_key[group].begin(), group_key[group].end(),
+				[](const Line_Key *a, const Line_Key *b) { return *a < *b; });
+			stable_sort(lines.begin(), lines.end(),
+				[&line_key](unsigned short a, unsigned short b) { return line_key[a] < line_key[b]; });
+			tied_orders(lines, [&line_key](unsigned short a, unsigned short b) { return line_key[a] == line_key[b]; },
+						limit, inner[group]);
+		}
+
+		vector<unsigned short> groups;
+		for (unsigned short group = 0; group < num_groups; ++group) {
+			groups.push_back(group);
+		}
+		stable_sort(groups.begin(), groups.end(),
+			[&group_key](unsigned short a, unsigned short b) { return key_less(group_key[a], group_key[b]); });
+		vector<unsigned short> group_orders;
+		tied_orders(groups, [&group_key](unsigned short a, unsigned short b) { return key_equal(group_key[a], group_key[b]); },
+					limit, group_orders);
+
+		//every group order combined with every choice of order within each group
+		orders.clear();
+		size_t count = 0;
+		for (size_t first = 0; first < group_orders.size(); first += num_groups) {
+			const unsigned short *group_order = group_orders.data() + first;
+			vector<size_t> choice(num_groups, 0);
+			while (count < limit) {
+				for (unsigned short i = 0; i < num_groups; ++i) {
+					unsigned short group = group_order[i];
+					auto lines = inner[group].begin() + (long) (choice[group] * group_size);
+					orders.insert(orders.end(), lines, lines + group_size);
+				}
+				++count;
+
+				//the last group of the order changes fastest
+				unsigned short k = num_groups;
+				while (k > 0 && ++choice[group_order[k-1]] * group_size == inner[group_order[k-1]].size()) {
+					choice[group_order[k-1]] = 0;
+					--k;
+				}
+				if (k == 0) {
+					break;
+				}
+			}
+		}
+		return count;
+	}
+}
+
+
+Canonical_Form::Canonical_Form(const Sudoku &sudoku)
+	: box_rows{sudoku.get_box_rows()}, box_cols{sudoku.get_box_cols()}, size{sudoku.get_size()} {
+	if (!sudoku.get_model().is_classic()) {
+		throw Constraint_Error("canonical forms only exist for classic rules");
+	}
+	vector<unsigned short> input((size_t) size * size);
+	for (unsigned short row = 0; row < size; ++row) {
+		for (unsigned short col = 0; col < size; ++col) {
+			input[(size_t) row * size + col] = sudoku.get_val(row, col);
+		}
+	}
+	compute(input.data());
+}
+
+
+Canonical_Form::Canonical_Form(unsigned short box_rows_in, unsigned short box_cols_in, const unsigned short *input)
+	: box_rows{box_rows_in}, box_cols{box_cols_in}, size{(unsigned short) (box_rows_in * box_cols_in)} {
+	compute(input);
+}
+
+
+void Canonical_Form::compute(const unsigned short *input) {
+	size_t num_blocks = (size_t) size * size;
+
+	//how often each value is given, which relabelling only moves between values
+	vector<unsigned int> value_count(size + 1, 0);
+	for (size_t i = 0; i < num_blocks; ++i) {
+		++value_count[input[i]];
+	}
+
+	vals.assign(num_blocks, 0);
+	bool have_best = false;
+	vector<unsigned short> current(num_blocks);
+	vector<unsigned short> relabel(size + 1, 0);
+	//comparison with the best form (<0: smaller, 0: equal so far) and next label at the
+	//start of each row of current, so that a row order sharing its first rows with the
+	//one before only compares the rows after them
+	vector<int> order_at(size + 1);
+	vector<unsigned short> label_at(size + 1);
+
+	//buffers reused by both orientations
+	vector<unsigned int> row_count(size), col_count(size);
+	vector<Line_Key> row_key(size), col_key(size);
+	vector<unsigned short> row_orders, col_orders;
+
+	//transposing only keeps the box shape if boxes are square
+	for (int t = 0; t < (box_rows == box_cols ? 2 : 1); ++t) {
+		bool transposed = (t == 1);
+		auto at = [&](unsigned short row, unsigned short col) {
+			return transposed ? input[(size_t) col * size + row] : input[(size_t) row * size + col];
+		};
+
+		fill(row_count.begin(), row_count.end(), 0u);
+		fill(col_count.begin(), col_count.end(), 0u);
+		for (unsigned short row = 0; row < size; ++row) {
+			for (unsigned short col = 0; col < size; ++col) {
+				if (at(row, col) != Block::BLANK) {
+					++row_count[row];
+					++col_count[col];
+				}
+			}
+		}
+		for (unsigned short i = 0; i < size; ++i) {
+			row_key[i].clear();
+			col_key[i].clear();
+		}
+		for (unsigned short row = 0; row < size; ++row) {
+			for (unsigned short col = 0; col < size; ++col) {
+				unsigned short val = at(row, col);
+				if (val != Block::BLANK) {
+					row_key[row].push_back((col_count[col] << 16) | value_count[val]);
+					col_key[col].push_back((row_count[row] << 16) | value_count[val]);
+				}
+			}
+		}
+		for (unsigned short i = 0; i < size; ++i) {
+			sort(row_key[i].begin(), row_key[i].end());
+			sort(col_key[i].begin(), col_key[i].end());
+		}
+
+		//bands hold box_rows rows, stacks hold box_cols cols
+		size_t num_row_orders = line_orders(row_key, box_cols, box_rows, MAX_CANDIDATES + 1, row_orders);
+		size_t num_col_orders = line_orders(col_key, box_rows, box_cols, MAX_CANDIDATES + 1, col_orders);
+		if (num_row_orders * num_col_orders > MAX_CANDIDATES) {
+			//too many ties, break them by position
+			num_row_orders = num_col_orders = 1;
+		}
+
+		for (size_t c = 0; c < num_col_orders; ++c) {
+			const unsigned short *cols = col_orders.data() + c * size;
+			//the row order compared before, the rows of it compared in full, and the row
+			//it was found larger than the best form at (size if it was not)
+			const unsigned short *last_rows = nullptr;
+			unsigned short rows_done = 0;
+			unsigned short larger_at = size;
+			order_at[0] = have_best ? 0 : -1;
+			label_at[0] = 1;
+
+			for (size_t r = 0; r < num_row_orders; ++r) {
+				const unsigned short *rows = row_orders.data() + r * size;
+				unsigned short shared = 0;
+				while (last_rows != nullptr && shared < size && rows[shared] == last_rows[shared]) {
+					++shared;
+				}
+				if (shared > larger_at) {
+					continue; //same rows up to where the last order was larger, so larger too
+				}
+
+				//carry on from the first row that differs, renumbering values in order of
+				//first appearance while comparing with the best so far
+				unsigned short first_row = min(shared, rows_done);
+				int order = order_at[first_row];
+				unsigned short next_label = label_at[first_row];
+				for (unsigned short val = 1; val <= size; ++val) {
+					if (relabel[val] >= next_label) {
+						relabel[val] = 0;
+					}
+				}
+				last_rows = rows;
+				rows_done = size;
+				larger_at = size;
+				for (unsigned short row = first_row; row < size && order <= 0; ++row) {
+					order_at[row] = order;
+					label_at[row] = next_label;
+					size_t i = (size_t) row * size;
+					for (unsigned short col = 0; col < size; ++col, ++i) {
+						unsigned short val = at(rows[row], cols[col]);
+						if (val != Block::BLANK) {
+							if (relabel[val] == 0) {
+								relabel[val] = next_label++;
+							}
+							val = relabel[val];
+						}
+						if (order == 0 && val != vals[i]) {
+							order = (val < vals[i]) ? -1 : 1;
+							if (order > 0) {
+								rows_done = larger_at = row;
+								break;
+							}
+						}
+						current[i] = val;
+					}
+				}
+				if (order >= 0) {
+					continue; //not smaller than the best form
+				}
+
+				//current is the best form now, equal to it in every row
+				have_best = true;
+				copy(current.begin(), current.end(), vals.begin());
+				fill(order_at.begin(), order_at.end(), 0);
+				transpose = transposed;
+				row_of.assign(rows, rows + size);
+				col_of.assign(cols, cols + size);
+				digit_map = relabel;
+				//values not given take the remaining labels in increasing order
+				for (unsigned short val = 1; val <= size; ++val) {
+					if (digit_map[val] == 0) {
+						digit_map[val] = next_label++;
+					}
+				}
+			}
+		}
+	}
+
+	digit_unmap.assign(size + 1, 0);
+	for (unsigned short val = 0; val <= size; ++val) {
+		digit_unmap[digit_map[val]] = val;
+	}
+}
+
+
+const vector<unsigned short>& Canonical_Form::get_vals() const {
+	return vals;
+}
+
+
+string Canonical_Form::key() const {
+	string key;
+	key.reserve(2 + vals.size());
+	key.push_back((char) box_rows);
+	key.push_back((char) box_cols);
+	for (auto val : vals) {
+		key.push_back((char) val); //values are at most 64
+	}
+	return key;
+}
+
+
+unsigned short Canonical_Form::get_size() const {
+	return size;
+}
+
+
+void Canonical_Form::to_canonical(const unsigned short *in, unsigned short *out) const {
+	for (unsigned short row = 0; row < size; ++row) {
+		for (unsigned short col = 0; col < size; ++col) {
+			size_t source = transpose ? (size_t) col_of[col] * size + row_of[row]
+										: (size_t) row_of[row] * size + col_of[col];
+			out[(size_t) row * size + col] = digit_map[in[source]];
+		}
+	}
+}
+
+
+void Canonical_Form::from_canonical(const unsigned short *in, unsigned short *out) const {
+	for (unsigned short row = 0; row < size; ++row) {
+		for (unsigned short col = 0; col < size; ++col) {
+			size_t source = transpose ? (size_t) col_of[col] * size + row_of[row]
+										: (size_t) row_of[row] * size + col_of[col];
+			out[source] = digit_unmap[in[(size_t) row * size + col]];
+		}
+	}
+}
+
+
+Solution_Cache::Solution_Cache(size_t memory_limit_in, const string &path_in)
+	: memory_limit{memory_limit_in}, path{path_in} {
+	if (!path.empty()) {
+		load_file();
+	}
+}
+
+
+bool Solution_Cache::lookup(const Canonical_Form &form, unsigned short *solution) {
+	string key = form.key();
+	vector<unsigned short> canonical(form.get_vals().size());
+
+	{
+		lock_guard<mutex> lock(cache_mutex);
+		auto it = index.find(key);
+		if (it == index.end()) {
+			++misses;
+			return false;
+		}
+		const string &stored = it->second->solution;
+		const vector<unsigned short> &givens = form.get_vals();
+		bool keeps_givens = true;
+		for (size_t i = 0; i < canonical.size(); ++i) {
+			canonical[i] = (unsigned char) stored[i];
+			keeps_givens = keeps_givens && (givens[i] == 0 || canonical[i] == givens[i]);
+		}
+		//the symmetries map solutions to solutions, so the canonical layout is checked;
+		//an entry that does not solve the board (a damaged file) is dropped
+		if (!keeps_givens || !check_solution((unsigned char) key[0], (unsigned char) key[1], canonical.data()).ok()) {
+			memory_usage -= entry_bytes(*it->second);
+			entries.erase(it->second);
+			index.erase(it);
+			++misses;
+			return false;
+		}
+		++hits;
+		entries.splice(entries.begin(), entries, it->second); //now most recently used
+	}
+
+	form.from_canonical(canonical.data(), solution);
+	return true;
+}
+
+
+void Solution_Cache::insert(const Canonical_Form &form, const unsigned short *solution) {
+	vector<unsigned short> canonical(form.get_vals().size());
+	form.to_canonical(solution, canonical.data());
+	Entry entry;
+	entry.key = form.key();
+	entry.solution.reserve(canonical.size());
+	for (auto val : canonical) {
+		entry.solution.push_back((char) val);
+	}
+
+	lock_guard<mutex> lock(cache_mutex);
+	if (log.is_open()) {
+		append_entry(entry);
+	}
+	insert_entry(move(entry));
+}
+
+
+void Solution_Cache::insert_entry(Entry entry) {
+	auto it = index.find(entry.key);
+	if (it != index.end()) {
+		memory_usage -= entry_bytes(*it->second);
+		entries.erase(it->second);
+		index.erase(it);
+	}
+
+	memory_usage += entry_bytes(entry);
+	entries.push_front(move(entry));
+	index[entries.front().key] = entries.begin();
+
+	while (memory_usage > memory_limit && !entries.empty()) {
+		auto &oldest = entries.back();
+		memory_usage -= entry_bytes(oldest);
+		index.erase(oldest.key);
+		entries.pop_back();
+	}
+}
+
+
+size_t Solution_Cache::entry_bytes(const Entry &entry) {
+	//the key is held twice (entry and index); node and bucket overhead is approximate
+	return 2 * entry.key.size() + entry.solution.size() + 2 * sizeof(Entry) + 64;
+}
+
+
+void Solution_Cache::append_entry(const Entry &entry) {
+	log.write(entry.key.data(), (streamsize) entry.key.size());
+	log.write(entry.solution.data(), (streamsize) entry.solution.size());
+	log.flush();
+}
+
+
+void Solution_Cache::load_file() {
+	bool exists = ifstream(path, ios::binary).is_open();
+	//bytes up to the end of the last complete entry, and the size of the file
+	size_t good_len = 0, file_len = 0;
+	if (exists) {
+		try {
+			Mapped_File file(path);
+			const unsigned char *data = file.data();
+			size_t len = file.size();
+			if (len < CACHE_HEADER_BYTES || memcmp(data, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0) {
+				throw Cache_Error(path + " is not a solution cache");
+			} else if (data[4] != CACHE_VERSION) {
+				throw Cache_Error(path + " has unsupported version " + to_string(data[4]));
+			}
+
+			size_t pos = CACHE_HEADER_BYTES;
+			while (pos + 2 <= len) {
+				size_t num_blocks = (size_t) data[pos] * data[pos + 1] * data[pos] * data[pos + 1];
+				if (num_blocks == 0 || pos + 2 + 2 * num_blocks > len || !valid_entry(data + pos, num_blocks)) {
+					break; //a partly written last entry, or a damaged one and all after it, is dropped
+				}
+				Entry entry;
+				entry.key.assign((const char *) data + pos, 2 + num_blocks);
+				entry.solution.assign((const char *) data + pos + 2 + num_blocks, num_blocks);
+				insert_entry(move(entry));
+				pos += 2 + 2 * num_blocks;
+			}
+			good_len = pos;
+			file_len = len;
+		} catch (Archive_Error &err) {
+			throw Cache_Error(err.msg);
+		}
+	}
+
+	//cut a torn or damaged entry off, or new entries would be appended after it and be lost
+	//(with everything after them) on the next load
+	if (good_len < file_len && truncate(path.c_str(), (off_t) good_len) != 0) {
+		throw Cache_Error("cannot truncate damaged entries off " + path);
+	}
+
+	log.open(path, ios::binary | ios::app);
+	if (!log.is_open()) {
+		throw Cache_Error("cannot open " + path + " for writing");
+	}
+	if (!exists) {
+		unsigned char header[CACHE_HEADER_BYTES] = {};
+		memcpy(header, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+		header[4] = CACHE_VERSION;
+		log.write((const char *) header, sizeof(header));
+		log.flush();
+	}
+}
+
+
+void Solution_Cache::save() {
+	lock_guard<mutex> lock(cache_mutex);
+	if (path.empty()) {
+		return;
+	}
+
+	//write a fresh file next to the old one, then replace it
+	string tmp_path = path + ".tmp";
+	{
+		ofstream out(tmp_path, ios::binary | ios::trunc);
+		unsigned char header[CACHE_HEADER_BYTES] = {};
+		memcpy(header, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+		header[4] = CACHE_VERSION;
+		out.write((const char *) header, sizeof(header));
+		//least recently used first, so reloading restores the same order
+		for (auto it = entries.rbegin(); it != entries.rend(); ++it) {
+			out.write(it->key.data(), (streamsize) it->key.size());
+			out.write(it->solution.data(), (streamsize) it->solution.size());
+		}
+		if (!out) {
+			throw Cache_Error("cannot write " + tmp_path);
+		}
+	}
+	log.close();
+	if (rename(tmp_path.c_str(), path.c_str()) != 0) {
+		throw Cache_Error("cannot replace " + path);
+	}
+	log.open(path, ios::binary | ios::app);
+	if (!log.is_open()) {
+		throw Cache_Error("cannot open " + path + " for writing");
+	}
+}
+
+
+size_t Solution_Cache::get_memory_usage() const {
+	lock_guard<mutex> lock(cache_mutex);
+	return memory_usage;
+}
+
+
+size_t Solution_Cache::get_num_entries() const {
+	lock_guard<mutex> lock(cache_mutex);
+	return entries.size();
+}
+
+
+size_t Solution_Cache::get_hits() const {
+	lock_guard<mutex> lock(cache_mutex);
+	return hits;
+}
+
+
+size_t Solution_Cache::get_misses() const {
+	lock_guard<mutex> lock(cache_mutex);
+	return misses;
+}
@@ -0,0 +1,183 @@
+#ifndef SOLUTION_CACHE_H
+#define SOLUTION_CACHE_H
+
+#include <cstddef>
+#include <fstream>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class Sudoku;
+
+//The canonical form of a classic sudoku board under the symmetries that map
+//solutions to solutions: relabelling the values, swapping bands (groups of box_rows
+//rows), swapping rows within a band, swapping stacks and columns within a stack, and,
+//for square boxes, transposing (which together with the swaps covers rotations and
+//reflections). Equivalent boards get the same canonical values, so a solution found for
+//one serves them all.
+//
+//The canonical form is the lexicographically smallest board (values renumbered in
+//order of first appearance) over the row and column orders that sort lines, bands and
+//stacks by keys that the symmetries do not change; only lines with equal keys are tried
+//in every order. If that is more than MAX_CANDIDATES orders, ties are broken by position
+//instead: equivalent boards may then get different forms (a cache miss), but the form
+//and its transform always stay correct.
+class Canonical_Form {
+public:
+	//most row and column orders tried for one board
+	static constexpr size_t MAX_CANDIDATES = 4096;
+
+	//REQUIRES: sudoku has classic rules
+	//EFFECTS: computes the canonical form of sudoku's board
+	//		throws Constraint_Error() if sudoku has variant rules
+	Canonical_Form(const Sudoku &sudoku);
+
+	//REQUIRES: vals points to (box_rows*box_cols)^2 values in [0:box_rows*box_cols]
+	//EFFECTS: computes the canonical form of the board vals (row-major, 0 for blank)
+	Canonical_Form(unsigned short box_rows, unsigned short box_cols, const unsigned short *vals);
+
+	//EFFECTS: returns the canonical values in row-major order
+	const std::vector<unsigned short>& get_vals() const;
+
+	//EFFECTS: returns the box shape and canonical values packed into a string,
+	//		equal for equivalent boards (see above)
+	std::string key() const;
+
+	//EFFECTS: returns the dimension of the board
+	unsigned short get_size() const;
+
+	//REQUIRES: in and out point to size^2 values
+	//MODIFIES: out
+	//EFFECTS: applies the transform to a board laid out like the input board (e.g. its solution)
+	void to_canonical(const unsigned short *in, unsigned short *out) const;
+
+	//REQUIRES: in and out point to size^2 values
+	//MODIFIES: out
+	//EFFECTS: applies the inverse transform, laying out a canonical board like the input board
+	void from_canonical(const unsigned short *in, unsigned short *out) const;
+
+private:
+	unsigned short box_rows;
+	unsigned short box_cols;
+	unsigned short size;
+
+	//canonical block (row, col) holds digit_map[input block source(row, col)], where
+	//source(row, col) is (row_of[row], col_of[col]), or (col_of[col], row_of[row]) if transposed
+	bool transpose;
+	std::vector<unsigned short> row_of;
+	std::vector<unsigned short> col_of;
+	std::vector<unsigned short> digit_map;   //input value -> canonical value, [0] = 0
+	std::vector<unsigned short> digit_unmap; //canonical value -> input value, [0] = 0
+
+	std::vector<unsigned short> vals;
+
+	//REQUIRES: input points to size^2 values
+	//MODIFIES: all members but box_rows, box_cols, size
+	//EFFECTS: searches the candidate orders for the canonical form of input
+	void compute(const unsigned short *input);
+};
+
+
+//A thread-safe cache of solutions keyed by canonical form, evicting the least
+//recently used entries to stay under a memory limit.
+//
+//Solutions are stored in canonical layout, so a board equivalent to a cached one
+//(relabelled, with rows or columns swapped, rotated, ...) is answered by mapping the
+//stored solution back onto it.
+//
+//If a file path is given, the cache is loaded from that file on construction and
+//every new entry is appended to it, so it survives restarts. The file is
+//memory-mapped when loaded. save() rewrites it with only the entries still cached.
+//
+//File layout: magic "SDKC", version 1, then any number of entries of
+//box_rows (1 byte), box_cols (1 byte), canonical board (size^2 bytes)
+//and its canonical solution (size^2 bytes).
+class Solution_Cache {
+public:
+	//EFFECTS: creates an empty cache holding at most memory_limit bytes of entries,
+	//		loading the entries in the file at path (if path is not empty and it exists)
+	//		throws Cache_Error() if the file exists but is not a solution cache
+	//		or cannot be opened for appending
+	Solution_Cache(size_t memory_limit, const std::string &path = "");
+
+	Solution_Cache(const Solution_Cache &) = delete;
+	Solution_Cache &operator=(const Solution_Cache &) = delete;
+
+	//REQUIRES: solution points to form.get_size()^2 writable values
+	//MODIFIES: solution, cache order, hits, misses
+	//EFFECTS: returns true and writes the solution of the board form was computed from
+	//		(in the input layout) to solution if an equivalent board is cached,
+	//		returns false otherwise (dropping a cached entry that does not solve the board)
+	bool lookup(const Canonical_Form &form, unsigned short *solution);
+
+	//REQUIRES: solution points to the solution of the board form was computed from
+	//MODIFIES: cache, file
+	//EFFECTS: caches solution (replacing any entry for the same form), evicting the
+	//		least recently used entries while over the memory limit, and appends it to the file
+	void insert(const Canonical_Form &form, const unsigned short *solution);
+
+	//MODIFIES: file
+	//EFFECTS: rewrites the file with only the entries currently cached
+	//		throws Cache_Error() if the file cannot be written
+	void save();
+
+	//EFFECTS: returns the bytes of memory charged to cached entries
+	size_t get_memory_usage() const;
+
+	//EFFECTS: returns the number of cached entries
+	size_t get_num_entries() const;
+
+	//EFFECTS: returns the number of lookups that found (hits) or did not find (misses) an entry
+	size_t get_hits() const;
+	size_t get_misses() const;
+
+private:
+	struct Entry {
+		std::string key;      //Canonical_Form::key()
+		std::string solution; //canonical solution, one byte per block
+	};
+
+	size_t memory_limit;
+	std::string path;
+
+	mutable std::mutex cache_mutex;
+	//most recently used entry at the front
+	std::list<Entry> entries;
+	std::unordered_map<std::string, std::list<Entry>::iterator> index;
+	size_t memory_usage = 0;
+	size_t hits = 0;
+	size_t misses = 0;
+	std::ofstream log;
+
+	//EFFECTS: returns the bytes charged for an entry, including list and index overhead
+	static size_t entry_bytes(const Entry &entry);
+
+	//REQUIRES: cache_mutex is held
+	//MODIFIES: entries, index, memory_usage
+	//EFFECTS: caches entry as most recently used, evicting entries while over the limit
+	void insert_entry(Entry entry);
+
+	//REQUIRES: cache_mutex is held, log is open
+	//MODIFIES: log
+	//EFFECTS: appends entry to the file
+	void append_entry(const Entry &entry);
+
+	//MODIFIES: entries, index, memory_usage
+	//EFFECTS: loads the entries of the file at path, cutting a partly written last entry
+	//		or the first damaged one (size above 64, values out of range) and all after it off
+	void load_file();
+};
+
+
+//Exception thrown on a malformed cache file or cache I/O failure
+class Cache_Error {
+public:
+	Cache_Error(const std::string &msg_in) : msg{"Solution cache: " + msg_in + "\n"} {}
+
+	std::string msg;
+};
+
+
+#endif
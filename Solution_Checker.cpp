@@ -0,0 +1,183 @@
+#include "Solution_Checker.h"
+
+#include <cstdint>
+
+using namespace std;
+
+/*Look at Solution_Checker.h for documention on functions' constraints and (side-)effects*/
+
+namespace {
+	//REQUIRES: the masks of size units
+	//EFFECTS: returns the index of the first mask that is not full, or size if all are
+	template <typename Mask>
+	unsigned short first_incomplete(const Mask *masks, unsigned short size, Mask full) {
+		for (unsigned short i = 0; i < size; ++i) {
+			if (masks[i] != full) {
+				return i;
+			}
+		}
+		return size;
+	}
+
+	//EFFECTS: turns the unit masks into a result
+	template <typename Mask>
+	Check_Result result_of(const Mask *rows, const Mask *cols, const Mask *boxes, unsigned short size, Mask full) {
+		Check_Result result;
+		if ((result.index = first_incomplete(rows, size, full)) != size) {
+			result.unit = Unit_Kind::ROW;
+		} else if ((result.index = first_incomplete(cols, size, full)) != size) {
+			result.unit = Unit_Kind::COL;
+		} else if ((result.index = first_incomplete(boxes, size, full)) != size) {
+			result.unit = Unit_Kind::BOX;
+		} else {
+			result.index = 0;
+		}
+		return result;
+	}
+
+	//any board: 64 bit masks, values outside [1:size] (including blanks) set no bit
+	Check_Result check_any(unsigned short box_rows, unsigned short box_cols, const unsigned short *vals) {
+		unsigned short size = (unsigned short) (box_rows * box_cols);
+		const uint64_t full = ~uint64_t(0) >> (64 - size);
+		uint64_t rows[64] = {}, cols[64] = {}, boxes[64] = {};
+		for (unsigned short row = 0; row < size; ++row) {
+			//box numbers of this row start at (row/box_rows)*box_rows, one per box_cols columns
+			unsigned short first_box = (unsigned short) ((row / box_rows) * box_rows);
+			for (unsigned short col = 0; col < size; ++col) {
+				unsigned int val = vals[(size_t) row * size + col];
+				uint64_t bit = (val - 1u < size) ? (uint64_t(1) << (val - 1u)) : 0;
+				rows[row] |= bit;
+				cols[col] |= bit;
+				boxes[first_box + col / box_cols] |= bit;
+			}
+		}
+		return result_of(rows, cols, boxes, size, full);
+	}
+
+
+	//EFFECTS: returns true iff vals is a correct 9x9 solution
+	//		Value val sets bit val with a single shift and no range check, so a unit is
+	//		correct iff its mask holds bits 1 to 9 (9 blocks, 9 distinct bits, no room for
+	//		a repeat). Each row's three segments give the box masks, and the columns are
+	//		written out so every mask stays in a register.
+	bool is_solution_9x9(const unsigned short *vals) {
+		const uint32_t full = 0x3FE;
+		uint32_t c0 = 0, c1 = 0, c2 = 0, c3 = 0, c4 = 0, c5 = 0, c6 = 0, c7 = 0, c8 = 0;
+		uint32_t b0 = 0, b1 = 0, b2 = 0;
+		uint32_t all = full;
+		uint32_t out_of_range = 0;
+		for (unsigned short row = 0; row < 9; ++row) {
+			const unsigned short *v = vals + row * 9;
+			//blanks and values up to 31 set a bit outside full, larger ones are caught below
+			uint32_t x0 = 1u << (v[0] & 31), x1 = 1u << (v[1] & 31), x2 = 1u << (v[2] & 31);
+			uint32_t x3 = 1u << (v[3] & 31), x4 = 1u << (v[4] & 31), x5 = 1u << (v[5] & 31);
+			uint32_t x6 = 1u << (v[6] & 31), x7 = 1u << (v[7] & 31), x8 = 1u << (v[8] & 31);
+			out_of_range |= (uint32_t) (v[0] | v[1] | v[2] | v[3] | v[4] | v[5] | v[6] | v[7] | v[8]);
+			c0 |= x0; c1 |= x1; c2 |= x2; c3 |= x3; c4 |= x4; c5 |= x5; c6 |= x6; c7 |= x7; c8 |= x8;
+			uint32_t s0 = x0 | x1 | x2, s1 = x3 | x4 | x5, s2 = x6 | x7 | x8;
+			all &= s0 | s1 | s2;
+			b0 |= s0; b1 |= s1; b2 |= s2;
+			if (row % 3 == 2) {
+				all &= b0 & b1 & b2;
+				b0 = b1 = b2 = 0;
+			}
+		}
+		all &= c0 & c1 & c2 & c3 & c4 & c5 & c6 & c7 & c8;
+		return all == full && out_of_range < 32;
+	}
+
+#ifdef __AVX2__
+	//9x9 grids checked together by check_solutions()
+	//(without per lane shifts, as in plain SSE2, is_solution_9x9() on each grid is faster)
+	constexpr size_t LANES = 16;
+
+	//REQUIRES: vals points to LANES 9x9 grids, ok to LANES writable flags
+	//MODIFIES: ok
+	//EFFECTS: sets ok[lane] iff grid lane is a correct 9x9 solution, by the test of
+	//		is_solution_9x9() run on all grids at once: the values are first interleaved
+	//		(cells[cell][lane]) so every step is a loop over the lanes that the compiler
+	//		turns into SIMD instructions, as in Batch_Solver
+	void are_solutions_9x9(const unsigned short *vals, bool *ok) {
+		const uint32_t full = 0x3FE;
+		uint16_t cells[81][LANES];
+		for (size_t cell = 0; cell < 81; ++cell) {
+			for (size_t lane = 0; lane < LANES; ++lane) {
+				cells[cell][lane] = vals[lane * 81 + cell];
+			}
+		}
+		uint32_t all[LANES], out_of_range[LANES] = {};
+		uint32_t cols[9][LANES] = {}, boxes[3][LANES] = {};
+		for (size_t lane = 0; lane < LANES; ++lane) {
+			all[lane] = full;
+		}
+		for (size_t row = 0; row < 9; ++row) {
+			uint32_t segments[3][LANES] = {};
+			for (size_t col = 0; col < 9; ++col) {
+				const uint16_t *block = cells[row * 9 + col];
+				for (size_t lane = 0; lane < LANES; ++lane) {
+					uint32_t bit = 1u << (block[lane] & 31);
+					out_of_range[lane] |= block[lane];
+					segments[col / 3][lane] |= bit;
+					cols[col][lane] |= bit;
+				}
+			}
+			for (size_t lane = 0; lane < LANES; ++lane) {
+				all[lane] &= segments[0][lane] | segments[1][lane] | segments[2][lane];
+				for (size_t stack = 0; stack < 3; ++stack) {
+					boxes[stack][lane] |= segments[stack][lane];
+				}
+			}
+			if (row % 3 == 2) {
+				for (size_t lane = 0; lane < LANES; ++lane) {
+					all[lane] &= boxes[0][lane] & boxes[1][lane] & boxes[2][lane];
+					boxes[0][lane] = boxes[1][lane] = boxes[2][lane] = 0;
+				}
+			}
+		}
+		for (size_t col = 0; col < 9; ++col) {
+			for (size_t lane = 0; lane < LANES; ++lane) {
+				all[lane] &= cols[col][lane];
+			}
+		}
+		for (size_t lane = 0; lane < LANES; ++lane) {
+			ok[lane] = all[lane] == full && out_of_range[lane] < 32;
+		}
+	}
+#endif
+}
+
+
+Check_Result check_solution(unsigned short box_rows, unsigned short box_cols, const unsigned short *vals) {
+	if (box_rows == 3 && box_cols == 3 && is_solution_9x9(vals)) {
+		return Check_Result();
+	}
+	//wrong grids take the slower path that finds the first violated unit
+	return check_any(box_rows, box_cols, vals);
+}
+
+
+size_t check_solutions(unsigned short box_rows, unsigned short box_cols, const unsigned short *vals,
+						size_t count, Check_Result *results) {
+	size_t num_blocks = (size_t) box_rows * box_cols * box_rows * box_cols;
+	size_t num_ok = 0;
+	size_t first = 0;
+#ifdef __AVX2__
+	if (box_rows == 3 && box_cols == 3) {
+		bool ok[LANES];
+		for (; first + LANES <= count; first += LANES) {
+			are_solutions_9x9(vals + first * num_blocks, ok);
+			for (size_t lane = 0; lane < LANES; ++lane) {
+				//wrong grids take the slower path that finds the first violated unit
+				results[first + lane] = ok[lane] ? Check_Result()
+										: check_any(box_rows, box_cols, vals + (first + lane) * num_blocks);
+				num_ok += ok[lane];
+			}
+		}
+	}
+#endif
+	for (size_t i = first; i < count; ++i) {
+		results[i] = check_solution(box_rows, box_cols, vals + i * num_blocks);
+		num_ok += results[i].ok();
+	}
+	return num_ok;
+}
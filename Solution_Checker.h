@@ -0,0 +1,51 @@
+#ifndef SOLUTION_CHECKER_H
+#define SOLUTION_CHECKER_H
+
+#include <cstddef>
+
+//Checks finished grids straight from raw values, without building a Sudoku or a solver.
+//
+//Each board is read once: every value sets its bit in a mask for its row, column and box,
+//and a unit is correct iff its mask ends up holding all size values (a blank, an out of range
+//value or a repeat leaves a bit missing). 9x9 boards first take a branch-free pass with
+//one shift per value, which check_solutions() runs on 16 grids at once when built for AVX2;
+//only grids it rejects are checked again to find the violated unit.
+
+//Kinds of unit a check can fail on
+enum class Unit_Kind {
+	NONE,	//the grid is a correct solution
+	ROW,
+	COL,
+	BOX
+};
+
+//Outcome of checking one grid
+struct Check_Result {
+	//first violated unit, rows checked before cols before boxes
+	Unit_Kind unit = Unit_Kind::NONE;
+	//row, col or box number of the violated unit
+	//(boxes are numbered left to right, top to bottom)
+	unsigned short index = 0;
+
+	//EFFECTS: returns true iff the grid is a correct solution
+	bool ok() const {
+		return unit == Unit_Kind::NONE;
+	}
+};
+
+//REQUIRES: vals points to (box_rows*box_cols)^2 values in row-major order,
+//			box_rows*box_cols is between 1 and 64
+//EFFECTS: returns whether vals is a full grid with every value [1:size] exactly once
+//		in every row, col and box, or else the first row, col or box that is not
+Check_Result check_solution(unsigned short box_rows, unsigned short box_cols, const unsigned short *vals);
+
+//REQUIRES: vals points to count grids as above, one after the other,
+//			results points to count writable results
+//MODIFIES: results
+//EFFECTS: checks every grid, storing the outcome of grid i in results[i]
+//		returns the number of correct grids
+size_t check_solutions(unsigned short box_rows, unsigned short box_cols, const unsigned short *vals,
+						size_t count, Check_Result *results);
+
+
+#endif
@@ -1,4 +1,6 @@
 #include "Sudoku.h"
+#include "Solution_Checker.h"
+#include "Board_Archive.h"
 #include <iomanip> //std::setw(), std::left
 
 using namespace std;
@@ -6,34 +8,147 @@ using namespace std;
 /*Look at Sudoku.h for documention on member functions' constraints and (side-)effects*/
 
 Sudoku::Sudoku(istream &is) {
-	is >> small_size;
-	size = (unsigned short) (small_size * small_size);
-	
-	board.resize(size);
+	unsigned short box_rows_in;
+	unsigned short box_cols_in;
+	is >> box_rows_in;
+	if (is.peek() == 'x') {
+		//rectangular boxes given as box_rows'x'box_cols
+		is.get();
+		is >> box_cols_in;
+	} else {
+		box_cols_in = box_rows_in;
+	}
+	reset_board(box_rows_in, box_cols_in);
 
+	unsigned short val;	
 	for (unsigned short row = 0; row < size; ++row) {
-		board[row].resize(size);
+		for (unsigned short col = 0; col < size; ++col) {
+			is >> val;
+			if (val > size) {
+				throw Value_Error("Sudoku constructor", val, size);
+			} else if (val == Block::BLANK) {
+				++num_blank;
+			}
+			vals[key(row, col)] = val;
+		}
 	}
 
-	num_blank = 0;
+	read_rules(is);
+}
+
+
+void Sudoku::read_rules(istream &is) {
+	string rule;
+	while (is >> rule) {
+		if (rule == "diagonal") {
+			model.add_diagonals();
+		} else if (rule == "jigsaw") {
+			vector<unsigned short> region_of((size_t) size * size);
+			for (auto &region : region_of) {
+				if (!(is >> region)) {
+					throw Constraint_Error("jigsaw needs a region index for every block");
+				}
+			}
+			model.set_regions(region_of);
+		} else if (rule == "cage") {
+			unsigned short sum;
+			unsigned short count;
+			if (!(is >> sum >> count)) {
+				throw Constraint_Error("cage needs a sum and a block count");
+			}
+			vector<unsigned short> keys;
+			for (unsigned short i = 0; i < count; ++i) {
+				unsigned short row;
+				unsigned short col;
+				if (!(is >> row >> col) || row >= size || col >= size) {
+					throw Constraint_Error("cage block " + to_string(i) + " missing or out of range");
+				}
+				keys.push_back(key(row, col));
+			}
+			model.add_cage(sum, keys);
+		} else {
+			throw Constraint_Error("unknown rule '" + rule + "'");
+		}
+	}
+}
+
+
+Sudoku::Sudoku(unsigned short small_size_in, const unsigned short *vals_in) {
+	load(small_size_in, small_size_in, vals_in);
+}
+
+
+Sudoku::Sudoku(unsigned short box_rows_in, unsigned short box_cols_in, const unsigned short *vals_in) {
+	load(box_rows_in, box_cols_in, vals_in);
+}
+
+
+void Sudoku::load(unsigned short small_size_in, const unsigned short *vals_in) {
+	load(small_size_in, small_size_in, vals_in);
+}
+
+
+void Sudoku::load(unsigned short box_rows_in, unsigned short box_cols_in, const unsigned short *vals_in) {
+	reset_board(box_rows_in, box_cols_in);
 
-	unsigned short val;	
 	for (unsigned short row = 0; row < size; ++row) {
 		for (unsigned short col = 0; col < size; ++col) {
-			is >> val;
+			unsigned short val = *vals_in++;
 			if (val > size) {
-				throw Value_Error("Sudoku constructor", val, size);
+				throw Value_Error("Sudoku::load", val, size);
+			} else if (val == Block::BLANK) {
+				++num_blank;
+			}
+			vals[key(row, col)] = val;
+		}
+	}
+}
+
+
+Sudoku::Sudoku(const Board_Archive &archive, size_t index) {
+	load(archive, index);
+}
+
+
+void Sudoku::load(const Board_Archive &archive, size_t index) {
+	if (index >= archive.get_count()) {
+		throw Archive_Error("board index " + to_string(index) + " out of range");
+	}
+	reset_board(archive.get_box_rows(), archive.get_box_cols());
+
+	size_t cell = 0;
+	for (unsigned short row = 0; row < size; ++row) {
+		for (unsigned short col = 0; col < size; ++col) {
+			//packed cells can hold values above size, so a damaged archive is caught here
+			unsigned short val = archive.get_cell(index, cell++);
+			if (val > size) {
+				throw Value_Error("Sudoku::load", val, size);
 			} else if (val == Block::BLANK) {
 				++num_blank;
-				board[row][col].key = key(row, col);
 			}
-			board[row][col].val = val;
+			vals[key(row, col)] = val;
 		}
 	}
+}
 
-	for (unsigned short i = 1; i < size+1; ++i) {
-		Domain.insert(i);
+
+void Sudoku::reset_board(unsigned short box_rows_in, unsigned short box_cols_in) {
+	if ((size_t) box_rows_in * box_cols_in > MAX_SIZE) {
+		throw Size_Error("Sudoku::reset_board", box_rows_in, box_cols_in);
 	}
+	box_rows = box_rows_in;
+	box_cols = box_cols_in;
+	size = (unsigned short) (box_rows * box_cols);
+	size_t num_blocks = (size_t) size * size;
+
+	//assign() keeps the existing capacity, so reloading a same-sized board does not allocate
+	vals.assign(num_blocks, Block::BLANK);
+	domains.assign(num_blocks, 0);
+	conflict_sets.assign(num_blocks * size, Block::NO_CONFLICT);
+
+	full_domain = (size == 0) ? 0 : (~Domain_Mask(0) >> (64 - size));
+	num_blank = 0;
+	model.reset(box_rows, box_cols);
 }
 
 
@@ -42,7 +157,7 @@ unsigned short Sudoku::get_val(unsigned short row, unsigned short col)  const {
 		throw Coordinate_Error("Sudoku::get_val", row, col, size);
 	}
 
-	return board[row][col].val;
+	return vals[key(row, col)];
 }
 
 
@@ -53,8 +168,8 @@ void Sudoku::set_val(unsigned short row, unsigned short col, unsigned short val)
 		throw Value_Error("Sudoku::set_val", val, size);
 	}
 
-	unsigned short original = board[row][col].val;
-	board[row][col].val = val;
+	unsigned short original = vals[key(row, col)];
+	vals[key(row, col)] = val;
 	if (val == Block::BLANK && original != Block::BLANK) {
 		++num_blank;
 	} else if (original == Block::BLANK && val != Block::BLANK) {
@@ -67,17 +182,18 @@ bool Sudoku::check_row(unsigned short row) const {
 	if (row >= size) {
 		throw Coordinate_Error("Sudoku::check_row", row, 0, size);
 	}
-	unordered_set <unsigned short> look_up;
+	Domain_Mask look_up = 0;
 	for (unsigned short col = 0; col < size; ++col) {
-		unsigned short val = board[row][col].val;
+		unsigned short val = vals[key(row, col)];
 		if (val == Block::BLANK) {
 			continue;
 		}
 
-		//if val of block is already in look_up and hence insertion fails
-		if (look_up.insert(val).second == false) {
+		//if val of block is already in look_up
+		if (look_up & domain_bit(val)) {
 			return false; //found duplicate
 		}
+		look_up |= domain_bit(val);
 	}
 	return true;
 }
@@ -97,17 +213,18 @@ bool Sudoku::check_col(unsigned short col) const {
 	if (col >= size) {
 		throw Coordinate_Error("Sudoku::check_col", 0, col, size);
 	}
-	unordered_set <unsigned short> look_up;
+	Domain_Mask look_up = 0;
 	for (unsigned short row = 0; row < size; ++row) {
-		unsigned short val = board[row][col].val;
+		unsigned short val = vals[key(row, col)];
 		if (val == Block::BLANK) {
 			continue;
 		}
 
-		//if val of block is already in look_up and hence insertion fails
-		if (look_up.insert(val).second == false) {
+		//if val of block is already in look_up
+		if (look_up & domain_bit(val)) {
 			return false; //found duplicate
 		}
+		look_up |= domain_bit(val);
 	}
 	return true;
 }
@@ -128,28 +245,105 @@ bool Sudoku::check_square(unsigned short index) const {
 		throw Index_Error();
 	}
 
-	unordered_set <unsigned short> look_up;
-	for (int i = 0; i < small_size; ++i) {
-		int row = int(index/small_size)*small_size + i;
+	Domain_Mask look_up = 0;
+	//there are box_rows boxes across each band of box_rows rows
+	for (int i = 0; i < box_rows; ++i) {
+		int row = int(index/box_rows)*box_rows + i;
 
-		for (int j = 0; j < small_size; ++j) {
-			int col = (index%small_size)*small_size + j;
+		for (int j = 0; j < box_cols; ++j) {
+			int col = (index%box_rows)*box_cols + j;
 
-			unsigned short val = board[row][col].val;
+			unsigned short val = vals[key((unsigned short) row, (unsigned short) col)];
 			if (val == Block::BLANK) {
 				continue;
 			}
 
-			//if val of block is already in look_up and hence insertion fails
-			if (look_up.insert(val).second == false) {
+			//if val of block is already in look_up
+			if (look_up & domain_bit(val)) {
 				return false; //found duplicate
 			}
+			look_up |= domain_bit(val);
 		}
 	}
 	return true;
 }
 
 
+bool Sudoku::check_unit(size_t index) const {
+	if (index >= model.get_num_units()) {
+		throw Index_Error();
+	}
+
+	Domain_Mask look_up = 0;
+	for (auto block : model.get_unit(index)) {
+		unsigned short val = vals[block];
+		if (val == Block::BLANK) {
+			continue;
+		}
+
+		//if val of block is already in look_up
+		if (look_up & domain_bit(val)) {
+			return false; //found duplicate
+		}
+		look_up |= domain_bit(val);
+	}
+	return true;
+}
+
+
+bool Sudoku::check_cage(size_t index) const {
+	if (index >= model.get_num_cages()) {
+		throw Index_Error();
+	}
+
+	const Cage &cage = model.get_cage(index);
+	unsigned int sum = 0;
+	unsigned short num_blank_in_cage = 0;
+	Domain_Mask used = 0;
+	for (auto block : cage.keys) {
+		unsigned short val = vals[block];
+		if (val == Block::BLANK) {
+			++num_blank_in_cage;
+		} else {
+			sum += val;
+			used |= domain_bit(val);
+		}
+	}
+	if (sum > cage.sum) {
+		return false;
+	}
+	unsigned int remaining = cage.sum - sum;
+
+	//remaining must lie between the smallest and largest totals of
+	//num_blank_in_cage distinct values not used in the cage yet
+	Domain_Mask unused = full_domain & ~used;
+	if (domain_count(unused) < num_blank_in_cage) {
+		return false;
+	}
+	unsigned int smallest = 0;
+	unsigned int largest = 0;
+	Domain_Mask low = unused;
+	Domain_Mask high = unused;
+	for (unsigned short i = 0; i < num_blank_in_cage; ++i) {
+		smallest += domain_first(low);
+		low &= low - 1;
+		largest += domain_last(high);
+		high &= ~domain_bit(domain_last(high));
+	}
+	return smallest <= remaining && remaining <= largest;
+}
+
+
+void Sudoku::set_model(const Constraint_Model &model_in) {
+	if (model_in.get_size() != size) {
+		throw Constraint_Error("rules for a " + to_string(model_in.get_size()) + "x"
+			+ to_string(model_in.get_size()) + " board given to a " + to_string(size) + "x"
+			+ to_string(size) + " sudoku");
+	}
+	model = model_in;
+}
+
+
 bool Sudoku::check_all_squares() const {
 	for (unsigned short i = 0; i < size; ++i) {
 		if (!check_square(i)) {
@@ -164,20 +358,62 @@ void Sudoku::print_board(ostream &os) const {
 	auto spacing = int (size/10+1);
 
 	for (unsigned short row = 0; row < size; ++row) {
-		if (row%small_size == 0 && row != 0) {
+		if (row%box_rows == 0 && row != 0) {
 			os << "\n";
 		}
 		for (unsigned short col = 0; col < size; ++col) {
-			if (col%small_size == 0 && col != 0) {
+			if (col%box_cols == 0 && col != 0) {
 				os << "\t";
 			}
-			os << setw(spacing) << std::left << board[row][col].val << " ";
+			os << setw(spacing) << std::left << vals[key(row, col)] << " ";
 		}
 		os << "\n";
 	}
 }
 
 
+void Sudoku::write_binary(ostream &os) const {
+	Board_Archive_Writer writer(os, box_rows, box_cols);
+	writer.write(*this);
+	writer.finish();
+}
+
+
+void Sudoku::write_state(ostream &os) const {
+	os.write((const char *) vals.data(), (streamsize) (vals.size() * sizeof(vals[0])));
+	os.write((const char *) domains.data(), (streamsize) (domains.size() * sizeof(domains[0])));
+	os.write((const char *) conflict_sets.data(),
+			(streamsize) (conflict_sets.size() * sizeof(conflict_sets[0])));
+	os.write((const char *) &num_blank, sizeof(num_blank));
+}
+
+
+bool Sudoku::read_state(istream &is) {
+	is.read((char *) vals.data(), (streamsize) (vals.size() * sizeof(vals[0])));
+	is.read((char *) domains.data(), (streamsize) (domains.size() * sizeof(domains[0])));
+	is.read((char *) conflict_sets.data(), (streamsize) (conflict_sets.size() * sizeof(conflict_sets[0])));
+	is.read((char *) &num_blank, sizeof(num_blank));
+	if (!is) {
+		return false;
+	}
+
+	//a damaged file must not leave values or keys that index out of the arrays
+	size_t blanks = 0;
+	for (size_t block = 0; block < vals.size(); ++block) {
+		if (vals[block] > size || (domains[block] & ~full_domain) != 0) {
+			return false;
+		}
+		blanks += vals[block] == Block::BLANK;
+	}
+	for (unsigned short conflict : conflict_sets) {
+		if (conflict >= vals.size() && conflict != Block::NO_CONFLICT) {
+			return false;
+		}
+	}
+	return blanks == num_blank;
+}
+
+
 unsigned short Sudoku::get_size() const {
 	return size;
 }
@@ -188,51 +424,153 @@ void Sudoku::update_domain(unsigned short row, unsigned short col) {
 		throw Coordinate_Error("Sudoku::update_domain", row, col, size);
 	}
 
-	if (board[row][col].val != Block::BLANK) {
+	if (vals[key(row, col)] != Block::BLANK) {
 		return;
 	}
 
-	auto &domain = board[row][col].domain;
-	domain = Domain;
+	Domain_Mask used = 0;
+
+	if (!model.is_classic()) {
+		//variant rules: check every block sharing a unit
+		unsigned short block = key(row, col);
+		for (auto peer = model.peers_begin(block); peer != model.peers_end(block); ++peer) {
+			if (vals[*peer] != Block::BLANK) {
+				used |= domain_bit(vals[*peer]);
+			}
+		}
+		domains[block] = full_domain & ~used;
+		return;
+	}
 
 	//check row
 	for (unsigned short j = 0; j < size; ++j) {
-		unsigned short val = board[row][j].val;
+		unsigned short val = vals[key(row, j)];
 		if (val == Block::BLANK) {
 			continue;
 		}
-		domain.erase(val);
+		used |= domain_bit(val);
 	}
 
 	//check column
 	for (unsigned short i = 0; i < size; ++i) {
-		unsigned short val = board[i][col].val;
+		unsigned short val = vals[key(i, col)];
 		if (val == Block::BLANK) {
 			continue;
 		}
-		domain.erase(val);
+		used |= domain_bit(val);
 	}
 
 	//check square
-	int start_row = row - row%small_size;
-	int start_col = col - col%small_size;
-	for (int i = start_row; i < start_row + small_size; ++i) {
-		for (int j = start_col; j < start_col + small_size; ++j) {
-			unsigned short val = board[i][j].val;
+	unsigned short start_row = (unsigned short) (row - row%box_rows);
+	unsigned short start_col = (unsigned short) (col - col%box_cols);
+	for (unsigned short i = start_row; i < start_row + box_rows; ++i) {
+		for (unsigned short j = start_col; j < start_col + box_cols; ++j) {
+			unsigned short val = vals[key(i, j)];
 			if (val == Block::BLANK) {
 				continue;
 			}
-			domain.erase(val);
+			used |= domain_bit(val);
 		}
 	}
+
+	domains[key(row, col)] = full_domain & ~used;
 }
 
 void Sudoku::update_all_domains() {
+	if (!model.is_classic()) {
+		for (unsigned short row = 0; row < size; ++row) {
+			for (unsigned short col = 0; col < size; ++col) {
+				update_domain(row, col);
+			}
+		}
+		return;
+	}
+
+	//one pass collects the values used by every row, col and square,
+	//a second gives each blank block what its three units leave
+	Domain_Mask row_used[MAX_SIZE] = {}, col_used[MAX_SIZE] = {}, square_used[MAX_SIZE] = {};
 	for (unsigned short row = 0; row < size; ++row) {
+		unsigned short first_square = (unsigned short) ((row / box_rows) * box_rows);
 		for (unsigned short col = 0; col < size; ++col) {
-			update_domain(row, col);
+			unsigned short val = vals[key(row, col)];
+			if (val == Block::BLANK) {
+				continue;
+			}
+			Domain_Mask bit = domain_bit(val);
+			row_used[row] |= bit;
+			col_used[col] |= bit;
+			square_used[first_square + col / box_cols] |= bit;
+		}
+	}
+	for (unsigned short row = 0; row < size; ++row) {
+		unsigned short first_square = (unsigned short) ((row / box_rows) * box_rows);
+		for (unsigned short col = 0; col < size; ++col) {
+			if (vals[key(row, col)] == Block::BLANK) {
+				domains[key(row, col)] = full_domain
+					& ~(row_used[row] | col_used[col] | square_used[first_square + col / box_cols]);
+			}
+		}
+	}
+}
+
+bool Sudoku::fill_singles(vector<unsigned short> &worklist) {
+	update_all_domains();
+
+	worklist.clear();
+	unsigned int num_blocks = (unsigned int) size * size;
+	for (unsigned short block = 0; block < num_blocks; ++block) {
+		if (vals[block] != Block::BLANK) {
+			continue;
+		} else if (domains[block] == 0) {
+			return false;
+		} else if ((domains[block] & (domains[block] - 1)) == 0) {
+			worklist.push_back(block);
 		}
 	}
+
+	while (!worklist.empty()) {
+		unsigned short block = worklist.back();
+		worklist.pop_back();
+		unsigned short val = domain_first(domains[block]);
+		vals[block] = val;
+		--num_blank;
+
+		//a peer left with one value is queued once, when it gets there
+		Domain_Mask bit = domain_bit(val);
+		bool contradiction = false;
+		auto take = [&](unsigned short peer) {
+			Domain_Mask &domain = domains[peer];
+			if (vals[peer] != Block::BLANK || (domain & bit) == 0) {
+				return;
+			}
+			domain &= ~bit;
+			if (domain == 0) {
+				contradiction = true;
+			} else if ((domain & (domain - 1)) == 0) {
+				worklist.push_back(peer);
+			}
+		};
+
+		if (!model.is_classic()) {
+			for (auto peer = model.peers_begin(block); peer != model.peers_end(block); ++peer) {
+				take(*peer);
+			}
+		} else {
+			unsigned short row = (unsigned short) (block / size);
+			unsigned short col = (unsigned short) (block % size);
+			unsigned short first_row = (unsigned short) (row - row % box_rows);
+			unsigned short first_col = (unsigned short) (col - col % box_cols);
+			for (unsigned short i = 0; i < size; ++i) {
+				take(key(row, i));
+				take(key(i, col));
+				take(key((unsigned short) (first_row + i / box_cols), (unsigned short) (first_col + i % box_cols)));
+			}
+		}
+		if (contradiction) {
+			return false;
+		}
+	}
+	return true;
 }
 
 bool Sudoku::domain_insert(unsigned short row, unsigned short col, unsigned short val) {
@@ -241,7 +579,10 @@ bool Sudoku::domain_insert(unsigned short row, unsigned short col, unsigned shor
 	} else if (val > size) {
 		throw Value_Error("Sudoku::domain_insert", val, size);
 	}
-	return board[row][col].domain.insert(val).second;
+	auto &domain = domains[key(row, col)];
+	bool inserted = !(domain & domain_bit(val));
+	domain |= domain_bit(val);
+	return inserted;
 }
 
 bool Sudoku::domain_erase(unsigned short row, unsigned short col, unsigned short val) {
@@ -250,28 +591,49 @@ bool Sudoku::domain_erase(unsigned short row, unsigned short col, unsigned short
 	} else if (val > size) {
 		throw Value_Error("Sudoku::domain_erase", val, size);
 	}
-	return board[row][col].domain.erase(val);
+	auto &domain = domains[key(row, col)];
+	bool erased = (domain & domain_bit(val)) != 0;
+	domain &= ~domain_bit(val);
+	return erased;
 }
 
-const unordered_set<unsigned short>& Sudoku::get_domain(unsigned short row, unsigned short col) const {
+Domain_Mask Sudoku::get_domain(unsigned short row, unsigned short col) const {
 	if (row >= size || col >= size) {
 		throw Coordinate_Error("Sudoku::get_domain", row, col, size);
 	}
-	return board[row][col].domain;
+	return domains[key(row, col)];
 }
 
 bool Sudoku::is_solved() const {
-	if (num_blank == 0
-		&& check_all_rows()
-		&& check_all_cols()
-		&& check_all_squares()) {
-		return true;
+	if (num_blank != 0) {
+		return false;
+	} else if (model.is_classic()) {
+		return check_solution(box_rows, box_cols, vals.data()).ok();
 	}
-	return false;
+
+	for (size_t i = 0; i < model.get_num_units(); ++i) {
+		if (!check_unit(i)) {
+			return false;
+		}
+	}
+	for (size_t i = 0; i < model.get_num_cages(); ++i) {
+		if (!check_cage(i)) {
+			return false;
+		}
+	}
+	return true;
 }
 
 unsigned short Sudoku::get_small_size() const {
-	return small_size;
+	return box_cols;
+}
+
+unsigned short Sudoku::get_box_rows() const {
+	return box_rows;
+}
+
+unsigned short Sudoku::get_box_cols() const {
+	return box_cols;
 }
 
 void Sudoku::conflict_set_insert(unsigned short row, unsigned short col,
@@ -279,10 +641,8 @@ void Sudoku::conflict_set_insert(unsigned short row, unsigned short col,
 	if (row >= size || col >= size || other_row >= size || other_col >= size) {
 		throw Coordinate_Error("Sudoku::conflict_set_insert", row, col, other_row, other_col, size);
 	}
-	auto &cs = board[row][col].conflict_set;
-	unsigned short key = get_key(other_row, other_col);
-	unsigned short val = get_val(other_row, other_col);
-	cs[key] = val;
+	unsigned short val = vals[key(other_row, other_col)];
+	conflict_sets[(size_t) key(row, col) * size + val-1] = key(other_row, other_col);
 }
 
 bool Sudoku::conflict_set_erase(unsigned short row, unsigned short col,
@@ -290,8 +650,17 @@ bool Sudoku::conflict_set_erase(unsigned short row, unsigned short col,
 	if (row >= size || col >= size || other_row >= size || other_col >= size) {
 		throw Coordinate_Error("Sudoku::conflict_set_erase", row, col, other_row, other_col, size);
 	}
-	unsigned short key = get_key(other_row, other_col);
-	return board[row][col].conflict_set.erase(key);
+	//the other block can only have eliminated its current value
+	unsigned short val = vals[key(other_row, other_col)];
+	if (val == Block::BLANK) {
+		return false;
+	}
+	auto &entry = conflict_sets[(size_t) key(row, col) * size + val-1];
+	if (entry != key(other_row, other_col)) {
+		return false;
+	}
+	entry = Block::NO_CONFLICT;
+	return true;
 }
 
 bool Sudoku::conflict_set_find(unsigned short row, unsigned short col,
@@ -299,27 +668,32 @@ bool Sudoku::conflict_set_find(unsigned short row, unsigned short col,
 	if (row >= size || col >= size || other_row >= size || other_col >= size) {
 		throw Coordinate_Error("Sudoku::conflict_set_find", row, col, other_row, other_col, size);
 	}
-	auto &conf_set = board[row][col].conflict_set;
-	unsigned short key = get_key(other_row, other_col);
-	return conf_set.find(key) != conf_set.end();
+	const unsigned short *cs = get_conflict_set(row, col);
+	unsigned short other_key = key(other_row, other_col);
+	for (unsigned short i = 0; i < size; ++i) {
+		if (cs[i] == other_key) {
+			return true;
+		}
+	}
+	return false;
 }
 
 unsigned short Sudoku::get_num_blank() const {
 	return num_blank;
 }
 
-const unordered_map<unsigned short, unsigned short>& Sudoku::get_conflict_set(unsigned short row, unsigned short col) const {
+const unsigned short* Sudoku::get_conflict_set(unsigned short row, unsigned short col) const {
 	if (row >= size || col >= size) {
 		throw Coordinate_Error("Sudoku::get_conflict_set", row, col, size);
 	}
-	return board[row][col].conflict_set;
+	return conflict_sets.data() + (size_t) key(row, col) * size;
 }
 
 unsigned short Sudoku::get_domain_size(unsigned short row, unsigned short col) const {
 	if (row >= size || col >= size) {
 		throw Coordinate_Error("Sudoku::get_domain_size", row, col, size);
 	}
-	return (unsigned short) (board[row][col].domain.size());
+	return domain_count(domains[key(row, col)]);
 }
 
 
@@ -327,5 +701,14 @@ unsigned short Sudoku::get_key(unsigned short row, unsigned short col) const {
 	if (row >= size || col >= size) {
 		throw Coordinate_Error("Sudoku::get_key", row, col, size);
 	}
-	return board[row][col].key;
+	return key(row, col);
+}
+
+
+Memory_Usage Sudoku::memory_usage() const {
+	Memory_Usage usage;
+	usage.board = vals.capacity() * sizeof(unsigned short);
+	usage.domains = domains.capacity() * sizeof(Domain_Mask);
+	usage.conflict_sets = conflict_sets.capacity() * sizeof(unsigned short);
+	return usage;
 }
@@ -5,40 +5,131 @@
 #include <iostream>
 #include <sstream>
 #include <string>
-#include <unordered_set>
-#include <unordered_map>
+#include <cstdint>
 
+#include "Constraint_Model.h"
 
-//Representaiton of a block in a sudoku
+class Board_Archive;
+
+//Domain_Mask: a set of sudoku values, bit (val-1) is set iff val is in the set
+//a single 64 bit word covers the values of every board up to 64x64
+typedef std::uint64_t Domain_Mask;
+
+//EFFECTS: returns the set containing only val
+inline Domain_Mask domain_bit(unsigned short val) {
+	return Domain_Mask(1) << (val - 1);
+}
+
+//EFFECTS: returns the number of values in domain
+inline unsigned short domain_count(Domain_Mask domain) {
+	return (unsigned short) __builtin_popcountll(domain);
+}
+
+//REQUIRES: domain is not empty
+//EFFECTS: returns the smallest value in domain
+inline unsigned short domain_first(Domain_Mask domain) {
+	return (unsigned short) (__builtin_ctzll(domain) + 1);
+}
+
+//REQUIRES: domain is not empty
+//EFFECTS: returns the largest value in domain
+inline unsigned short domain_last(Domain_Mask domain) {
+	return (unsigned short) (64 - __builtin_clzll(domain));
+}
+
+//Constants describing a block in a sudoku
 //a blank block is represented as a block with val of 0
+//(Sudoku stores its blocks' values, domains and conflict sets in flat arrays indexed by key)
 class Block {
 public:
-	Block(): val{BLANK} {}
-
-	Block(unsigned short val_in) : val{val_in} {}
+	static constexpr unsigned short BLANK = 0; //represents that a block is blank
+	//marks a value in a conflict set that no other block eliminated
+	static constexpr unsigned short NO_CONFLICT = 0xFFFF;
+};
 
-	unsigned short key; //key to identify block on sudoku board
-	unsigned short val;
-	//domain: possible values the blank block can have
-	std::unordered_set<unsigned short> domain;
-	//conflict set: keys and values of other blocks that eliminated a value from this block's domain
-	std::unordered_map<unsigned short, unsigned short> conflict_set;
+//Bytes of heap memory held by the working state of a sudoku (and its solver)
+struct Memory_Usage {
+	size_t board = 0; //block values
+	size_t domains = 0;
+	size_t conflict_sets = 0;
+	size_t tracker = 0; //only filled in by Sudoku_Solver::memory_usage()
+	size_t search = 0; //cumulative conflict set, decision path and singles worklist, also only by Sudoku_Solver
 
-	static const unsigned short BLANK = 0; //represents that a block is blank
+	size_t total() const {
+		return board + domains + conflict_sets + tracker + search;
+	}
 };
 
-//Representation of a nxn sudoku board
-//where size = n and small_size = n^(1/2)
+//Representation of a nxn sudoku board made of box_rows x box_cols boxes
+//where size = n = box_rows*box_cols (for the classic square boxes box_rows = box_cols = small_size)
+//
+//All per-block state lives in three flat arrays, (2 + 8 + 2*size) bytes per block,
+//so a 25x25 sudoku takes 625*60 = 37500 bytes, keeping its solver's whole working
+//state under 64 KiB, small enough to stay resident in L2 cache while solving.
 class Sudoku {
 public:
-	//REQUIRES: istream contains small_size, then small_size^4 number of sudoku values
-	//			that are all seperated by whitespace. Sudoku values must be 
-	//			non-negative values smaller than or equal to small_size^2
-	//MODIFIES: board, small_size, size, num_blank, Domain
+	//REQUIRES: istream contains the box shape, then size^2 number of sudoku values
+	//			that are all seperated by whitespace. The box shape is either small_size
+	//			for square boxes or box_rows'x'box_cols (e.g. 2x3) for rectangular boxes.
+	//			Sudoku values must be non-negative values smaller than or equal to size.
+	//			The values may be followed by variant rules:
+	//				diagonal                         both main diagonals are units (X-sudoku)
+	//				jigsaw <size^2 region indices>   irregular regions replace the boxes
+	//				cage <sum> <n> <row col> x n     killer cage (rows and cols count from 0)
+	//MODIFIES: vals, domains, conflict_sets, box_rows, box_cols, size, num_blank, model
 	//EFFECTS: creates sudoku object (does not compute sudoku blocks' domains)
 	//			throws Value_Error() if input value is invalid (i.e. val > size)
+	//			throws Size_Error() if size is larger than 64
+	//			throws Constraint_Error() if a variant rule is malformed
 	Sudoku(std::istream &is);
 
+	//REQUIRES: vals_in points to small_size_in^4 sudoku values in row-major order
+	//			that are non-negative values smaller than or equal to small_size^2
+	//MODIFIES: vals, domains, conflict_sets, box_rows, box_cols, size, num_blank
+	//EFFECTS: creates sudoku object with square boxes from raw cell values
+	//			(does not compute domains)
+	//			throws Value_Error() if input value is invalid (i.e. val > size)
+	//			throws Size_Error() if size is larger than 64
+	Sudoku(unsigned short small_size_in, const unsigned short *vals_in);
+
+	//REQUIRES: vals_in points to (box_rows_in*box_cols_in)^2 sudoku values in row-major
+	//			order that are non-negative values smaller than or equal to size
+	//MODIFIES: vals, domains, conflict_sets, box_rows, box_cols, size, num_blank
+	//EFFECTS: creates sudoku object with box_rows_in x box_cols_in boxes from raw cell values
+	//			(does not compute domains)
+	//			throws Value_Error() if input value is invalid (i.e. val > size)
+	//			throws Size_Error() if size is larger than 64
+	Sudoku(unsigned short box_rows_in, unsigned short box_cols_in, const unsigned short *vals_in);
+
+	//REQUIRES: vals_in points to small_size_in^4 sudoku values in row-major order
+	//MODIFIES: vals, domains, conflict_sets, box_rows, box_cols, size, num_blank
+	//EFFECTS: replaces the board with the given values, reusing the storage of
+	//			the previous board when the dimensions match, and clears all
+	//			domains and conflict sets
+	//			throws Value_Error() if input value is invalid (i.e. val > size)
+	//			throws Size_Error() if size is larger than 64
+	void load(unsigned short small_size_in, const unsigned short *vals_in);
+
+	//REQUIRES: vals_in points to (box_rows_in*box_cols_in)^2 sudoku values in row-major order
+	//MODIFIES: vals, domains, conflict_sets, box_rows, box_cols, size, num_blank
+	//EFFECTS: same as load() above, for a board of box_rows_in x box_cols_in boxes
+	void load(unsigned short box_rows_in, unsigned short box_cols_in, const unsigned short *vals_in);
+
+	//REQUIRES: index is smaller than archive.get_count()
+	//MODIFIES: vals, domains, conflict_sets, box_rows, box_cols, size, num_blank
+	//EFFECTS: creates sudoku object from board index of a binary archive,
+	//			reading the packed cells in place (does not compute domains)
+	//			throws Archive_Error() if index is out of range
+	//			throws Value_Error() if a cell holds a value above size (a damaged archive)
+	Sudoku(const Board_Archive &archive, size_t index);
+
+	//REQUIRES: index is smaller than archive.get_count()
+	//MODIFIES: vals, domains, conflict_sets, box_rows, box_cols, size, num_blank
+	//EFFECTS: same as load() above, but reads board index of a binary archive
+	//			throws Archive_Error() if index is out of range
+	//			throws Value_Error() if a cell holds a value above size (a damaged archive)
+	void load(const Board_Archive &archive, size_t index);
+
 	//REQUIRES: row, col are smaller than size
 	//EFFECTS: returns value of sudoku block at (row, col)
 	unsigned short get_val(unsigned short row, unsigned short col) const;
@@ -66,7 +157,7 @@ public:
 	//		values in the same col
 	bool check_all_cols() const;
 	
-	//EFFECTS: returns true iff sudoku square with index have no duplicate values
+	//EFFECTS: returns true iff sudoku square (box) with index have no duplicate values
 	// 		index increases by across and down, starting from top left square
 	// 		and ending bottom right square
 	//		throws Index_Error() if argument requirement is not met
@@ -75,15 +166,61 @@ public:
 	//EFFECTS: returns true iff all sudoku blocks do not have duplicate
 	//		values in the same square
 	bool check_all_squares() const;
+
+	//REQUIRES: index is smaller than get_model().get_num_units()
+	//EFFECTS: returns true iff sudoku blocks in unit index of a variant model
+	//		have no duplicate values
+	bool check_unit(size_t index) const;
+
+	//REQUIRES: index is smaller than get_model().get_num_cages()
+	//EFFECTS: returns true iff the blank blocks of killer cage index can still be
+	//		filled with distinct unused values that make the cage add up to its sum
+	bool check_cage(size_t index) const;
+
+	//REQUIRES: model_in is for a board of this size
+	//MODIFIES: model
+	//EFFECTS: replaces the rules of the sudoku with model_in (does not update domains)
+	//		throws Constraint_Error() if model_in is for a different size
+	void set_model(const Constraint_Model &model_in);
+
+	//EFFECTS: returns the rules of the sudoku by const reference
+	const Constraint_Model& get_model() const {
+		return model;
+	}
 	
 	//EFFECTS: pretty prints the sudoku board to ostream
 	void print_board(std::ostream &os) const;
+
+	//REQUIRES: os is open in binary mode and seekable
+	//EFFECTS: writes the sudoku board to ostream as a one-board binary archive
+	//			(see Board_Archive.h; use Board_Archive_Writer for many boards)
+	void write_binary(std::ostream &os) const;
+
+	//REQUIRES: os is open in binary mode
+	//MODIFIES: os
+	//EFFECTS: writes the working state of the board (values, domains, conflict sets and
+	//		number of blanks) as raw arrays in native byte order, for checkpoints
+	void write_state(std::ostream &os) const;
+
+	//REQUIRES: is is open in binary mode
+	//MODIFIES: vals, domains, conflict_sets, num_blank
+	//EFFECTS: reads back a working state written by write_state() for a board of this shape,
+	//		returns false if is ends first or the state is damaged (a value above size, a domain
+	//		with values above size, a conflict key off the board or a wrong number of blanks)
+	bool read_state(std::istream &is);
 	
 	//EFFECTS: returns size
 	unsigned short get_size() const;
 	
-	//EFFECTS: returns small_size
+	//REQUIRES: boxes are square
+	//EFFECTS: returns small_size, the width of a box
 	unsigned short get_small_size() const;
+
+	//EFFECTS: returns the number of rows in a box
+	unsigned short get_box_rows() const;
+
+	//EFFECTS: returns the number of columns in a box
+	unsigned short get_box_cols() const;
 	
 	//REQUIRES: row, col are smaller than size
 	//MODIFIES: domain of block at (row,col)
@@ -94,7 +231,17 @@ public:
 	//MODIFIES: domains of all blank blocks in sudoku
 	//EFFECTS: updates the domain of all block to contrain
 	//			their potential values iff the block is blank
+	//			(classic boards take a single pass over the board, not one per block)
 	void update_all_domains();
+
+	//REQUIRES: worklist has room for size^2 keys, for no allocation to happen
+	//MODIFIES: vals, domains, num_blank, worklist
+	//EFFECTS: updates the domains of all blank blocks, then fills every block left with a
+	//			single value, taking it from its peers' domains, until no such block is left
+	//			returns false if a blank block is left with no value (the board is unsolvable)
+	//			Blocks filled here are treated like given blocks: they are not recorded in
+	//			any conflict set, as only the given blocks forced them.
+	bool fill_singles(std::vector<unsigned short> &worklist);
 	
 	//REQUIRES: row, col are smaller than size
 	//			val is non-negative and smaller or equal to size
@@ -113,9 +260,8 @@ public:
 	unsigned short get_domain_size(unsigned short row, unsigned short col) const;
 	
 	//REQUIRES: row, col are smaller than size
-	//EFFECTS: returns the domain of block at (row,col) by const reference
-	const std::unordered_set<unsigned short>& 
-			get_domain(unsigned short row, unsigned short col) const;
+	//EFFECTS: returns the domain of block at (row,col)
+	Domain_Mask get_domain(unsigned short row, unsigned short col) const;
 	
 	//REQUIRES: row, col, other_row, other_col are smaller than size
 	//MODIFIES: conflict_set of block at (row,col)
@@ -138,11 +284,12 @@ public:
 					unsigned short other_row, unsigned short other_col) const;
 	
 	//REQUIRES: row, col are smaller than size
-	//EFFECTS: returns the conflict_set of block at (row,col) by const reference
-	const std::unordered_map<unsigned short, unsigned short>&
-			get_conflict_set(unsigned short row, unsigned short col) const;
+	//EFFECTS: returns the conflict_set of block at (row,col) as an array of size entries,
+	//		where entry val-1 is the key of the block (whose value is val) that eliminated
+	//		val from the domain of block at (row,col), or Block::NO_CONFLICT
+	const unsigned short* get_conflict_set(unsigned short row, unsigned short col) const;
 
-	//EFFECTS: returns true iff sudoku is solved
+	//EFFECTS: returns true iff sudoku is solved (obeying variant rules, if any)
 	bool is_solved() const;
 	
 	//EFFECTS: returns number of blank blocks in sudoku
@@ -152,20 +299,50 @@ public:
 	//EFFECTS: returns the key for the block at (row,col)
 	unsigned short get_key(unsigned short row, unsigned short col) const;
 
+	//EFFECTS: returns the bytes held by board values, domains and conflict sets
+	Memory_Usage memory_usage() const;
+
 private:
-	std::vector< std::vector<Block> > board;
+	//vals[key]: value of block key
+	std::vector<unsigned short> vals;
+
+	//domains[key]: domain of block key, only meaningful while the block is blank
+	std::vector<Domain_Mask> domains;
+
+	//conflict_sets[key*size + val-1]: key of the block that eliminated val from the domain
+	//of block key, or Block::NO_CONFLICT. A block only eliminates its own value, so this holds
+	//exactly the (key, val) pairs of the block's conflict set without any hashing.
+	std::vector<unsigned short> conflict_sets;
 
-	//small_size: width of the small square in sudoku
-	unsigned short small_size;
-	//size: small_size^2, the board's dimension is size x size
-	unsigned short size; // size = small_size^2
+	//box_rows, box_cols: height and width of the boxes (small squares) in sudoku
+	unsigned short box_rows;
+	unsigned short box_cols;
+	//size: box_rows*box_cols, the board's dimension is size x size
+	unsigned short size; // size = box_rows*box_cols
 
 	//num_blank: number of blank block in sudoku
 	unsigned short num_blank;
 
 	//contains natural numbers [1:size] inclusive for easy initialization of domains
-	//MUST NOT be modified although it is not const
-	std::unordered_set<unsigned short> Domain;
+	Domain_Mask full_domain;
+
+	//rules of the sudoku, classic (rows, cols, boxes) unless variant rules were given
+	Constraint_Model model;
+
+	//MODIFIES: model
+	//EFFECTS: reads variant rules following the values from is into model
+	//		throws Constraint_Error() if a rule is malformed
+	void read_rules(std::istream &is);
+
+	//largest size whose values fit in a Domain_Mask
+	static const unsigned short MAX_SIZE = 64;
+
+	//MODIFIES: vals, domains, conflict_sets, box_rows, box_cols, size, num_blank, full_domain, model
+	//EFFECTS: throws Size_Error() if box_rows_in*box_cols_in is larger than MAX_SIZE
+	//			resizes board to a size x size board of blank blocks with
+	//			box_rows_in x box_cols_in boxes and empty domains and conflict sets,
+	//			reusing existing storage, resets num_blank and makes model classic
+	void reset_board(unsigned short box_rows_in, unsigned short box_cols_in);
 
 	//REQUIRES: row, col are smaller than size
 	//EFFECTS: computes and returns the key for the block at (row,col)
@@ -210,6 +387,20 @@ public:
 };
 
 
+//Exception thrown when a sudoku is too large to be represented (size above 64)
+class Size_Error {
+public:
+	Size_Error(const char *function_name, unsigned short box_rows, unsigned short box_cols) {
+		std::ostringstream os;
+		os << "In function "<<function_name<<": "<<box_rows<<"x"<<box_cols<<" boxes "
+			<<"make a sudoku larger than the supported maximum of 64x64.\n";
+		msg = os.str();
+	}
+
+	std::string msg;
+};
+
+
 //Exception thrown when trying to set a sudoku block's value that is
 //out of range (negative or greater than width size)
 //thrown by set_value()
@@ -0,0 +1,222 @@
+#include "Sudoku_C_API.h"
+
+#include "Batch_Solver.h"
+#include "Sudoku_Solver.h"
+
+#include <algorithm> //copy(), fill(), count_if()
+#include <chrono>
+#include <memory>
+#include <new> //bad_alloc
+#include <string>
+
+using namespace std;
+
+/*Look at Sudoku_C_API.h for documention on functions' constraints and (side-)effects*/
+
+struct sudoku_solver {
+	//warm solver, reloaded for every board
+	Sudoku_Solver solver{0, nullptr};
+	//only built by the first batch of 9x9 boards
+	unique_ptr<Batch_Solver> batch;
+	//boards propagated by batch, before their solutions are copied out
+	unsigned short batch_solutions[Batch_Solver::LANES * Batch_Solver::CELLS];
+
+	chrono::milliseconds time_limit{0};
+	//search nodes of the last sudoku_solve(), or of all boards of the last sudoku_solve_batch()
+	unsigned long long nodes = 0;
+	string last_error;
+};
+
+namespace {
+	//MODIFIES: handle.solver, handle.nodes, handle.last_error, solution
+	//EFFECTS: does the work of sudoku_solve() for one board, turning every exception into a status
+	sudoku_status solve_one(sudoku_solver &handle, unsigned short box_rows, unsigned short box_cols,
+							const unsigned short *cells, unsigned short *solution) {
+		handle.nodes = 0;
+		if (box_rows == 0 || box_cols == 0) {
+			handle.last_error = "Boxes need at least one row and one column.";
+			return SUDOKU_BAD_ARGUMENT;
+		}
+		try {
+			handle.solver.load(box_rows, box_cols, cells); //validates the values and size
+			if (handle.time_limit.count() != 0) {
+				handle.solver.set_deadline(chrono::steady_clock::now() + handle.time_limit);
+			} else {
+				handle.solver.clear_deadline();
+			}
+
+			bool solved = handle.solver.solve();
+			handle.nodes = handle.solver.get_node_count();
+			if (!solved) {
+				handle.last_error = Sudoku_Error().msg;
+				return SUDOKU_UNSOLVABLE;
+			}
+
+			unsigned short size = handle.solver.get_size();
+			for (unsigned short row = 0; row < size; ++row) {
+				for (unsigned short col = 0; col < size; ++col) {
+					solution[(size_t) row * size + col] = handle.solver.get_val(row, col);
+				}
+			}
+			return SUDOKU_SOLVED;
+		} catch (Sudoku_Error &err) {
+			handle.nodes = handle.solver.get_node_count();
+			handle.last_error = err.msg;
+			return SUDOKU_UNSOLVABLE;
+		} catch (Timeout_Error &err) {
+			handle.nodes = handle.solver.get_node_count();
+			handle.last_error = err.msg;
+			return SUDOKU_TIMED_OUT;
+		} catch (Value_Error &err) {
+			handle.last_error = err.msg;
+			return SUDOKU_BAD_ARGUMENT;
+		} catch (Size_Error &err) {
+			handle.last_error = err.msg;
+			return SUDOKU_BAD_ARGUMENT;
+		} catch (bad_alloc &) {
+			handle.last_error = "Out of memory.";
+			return SUDOKU_OUT_OF_MEMORY;
+		} catch (...) {
+			handle.last_error = "Unexpected exception in the solver.";
+			return SUDOKU_INTERNAL_ERROR;
+		}
+	}
+
+	//REQUIRES: count is at most Batch_Solver::LANES, handle.batch is built
+	//MODIFIES: handle.batch, handle.batch_solutions, handle.nodes, handle.last_error, solutions, statuses
+	//EFFECTS: solves count 9x9 boards with the batch solver, setting handle.nodes to the nodes
+	//		they searched, returns false (writing nothing) if it throws, e.g. on a value above 9
+	bool solve_lanes(sudoku_solver &handle, const unsigned short *cells, size_t count,
+					unsigned short *solutions, sudoku_status *statuses) {
+		bool solved[Batch_Solver::LANES];
+		size_t nodes = handle.batch->get_node_count();
+		try {
+			handle.batch->solve(cells, count, handle.batch_solutions, solved);
+		} catch (...) {
+			return false;
+		}
+		handle.nodes = handle.batch->get_node_count() - nodes;
+		for (size_t i = 0; i < count; ++i) {
+			if (solved[i]) {
+				const unsigned short *board = handle.batch_solutions + i * Batch_Solver::CELLS;
+				copy(board, board + Batch_Solver::CELLS, solutions + i * Batch_Solver::CELLS);
+				statuses[i] = SUDOKU_SOLVED;
+			} else {
+				handle.last_error = Sudoku_Error().msg;
+				statuses[i] = SUDOKU_UNSOLVABLE;
+			}
+		}
+		return true;
+	}
+}
+
+
+sudoku_solver *sudoku_solver_create(void) {
+	try {
+		return new sudoku_solver;
+	} catch (...) {
+		return nullptr;
+	}
+}
+
+
+void sudoku_solver_destroy(sudoku_solver *solver) {
+	delete solver;
+}
+
+
+void sudoku_solver_set_time_limit(sudoku_solver *solver, unsigned long milliseconds) {
+	solver->time_limit = chrono::milliseconds(milliseconds);
+}
+
+
+sudoku_status sudoku_solve(sudoku_solver *solver, unsigned short box_rows, unsigned short box_cols,
+						const unsigned short *cells, unsigned short *solution) {
+	if (solver == nullptr) {
+		return SUDOKU_BAD_ARGUMENT;
+	}
+	solver->last_error.clear();
+	solver->nodes = 0;
+	if (cells == nullptr || solution == nullptr) {
+		solver->last_error = "Null board buffer.";
+		return SUDOKU_BAD_ARGUMENT;
+	}
+	return solve_one(*solver, box_rows, box_cols, cells, solution);
+}
+
+
+size_t sudoku_solve_batch(sudoku_solver *solver, unsigned short box_rows, unsigned short box_cols,
+						const unsigned short *cells, size_t count,
+						unsigned short *solutions, sudoku_status *statuses) {
+	if (solver == nullptr || statuses == nullptr) {
+		return 0;
+	}
+	solver->last_error.clear();
+	solver->nodes = 0;
+	if (cells == nullptr || solutions == nullptr) {
+		solver->last_error = "Null board buffer.";
+		fill(statuses, statuses + count, SUDOKU_BAD_ARGUMENT);
+		return 0;
+	}
+
+	size_t num_blocks = (size_t) box_rows * box_cols * box_rows * box_cols;
+	bool use_batch = box_rows == 3 && box_cols == 3 && solver->time_limit.count() == 0;
+	if (use_batch && !solver->batch) {
+		try {
+			solver->batch.reset(new Batch_Solver);
+		} catch (...) {
+			use_batch = false; //boards are still solved one by one
+		}
+	}
+
+	unsigned long long nodes = 0;
+	size_t first = 0;
+	while (first < count) {
+		size_t lanes = min(Batch_Solver::LANES, count - first);
+		//a chunk the batch solver throws on is solved one board at a time, to find the culprit
+		if (use_batch && solve_lanes(*solver, cells + first * num_blocks, lanes,
+									solutions + first * num_blocks, statuses + first)) {
+			nodes += solver->nodes;
+		} else {
+			for (size_t i = first; i < first + lanes; ++i) {
+				statuses[i] = solve_one(*solver, box_rows, box_cols,
+										cells + i * num_blocks, solutions + i * num_blocks);
+				nodes += solver->nodes;
+			}
+		}
+		first += lanes;
+	}
+	solver->nodes = nodes;
+	return (size_t) count_if(statuses, statuses + count, [](sudoku_status status) {
+		return status == SUDOKU_SOLVED;
+	});
+}
+
+
+unsigned long long sudoku_solver_node_count(const sudoku_solver *solver) {
+	return solver->nodes;
+}
+
+
+const char *sudoku_solver_last_error(const sudoku_solver *solver) {
+	return solver->last_error.c_str();
+}
+
+
+const char *sudoku_status_name(sudoku_status status) {
+	switch (status) {
+	case SUDOKU_SOLVED:
+		return "SUDOKU_SOLVED";
+	case SUDOKU_UNSOLVABLE:
+		return "SUDOKU_UNSOLVABLE";
+	case SUDOKU_TIMED_OUT:
+		return "SUDOKU_TIMED_OUT";
+	case SUDOKU_BAD_ARGUMENT:
+		return "SUDOKU_BAD_ARGUMENT";
+	case SUDOKU_OUT_OF_MEMORY:
+		return "SUDOKU_OUT_OF_MEMORY";
+	case SUDOKU_INTERNAL_ERROR:
+		return "SUDOKU_INTERNAL_ERROR";
+	}
+	return "SUDOKU_UNKNOWN_STATUS";
+}
@@ -0,0 +1,96 @@
+#ifndef SUDOKU_C_API_H
+#define SUDOKU_C_API_H
+
+#include <stddef.h>
+
+//C interface to the solver, for embedding it in services written in other languages.
+//
+//Boards go in and out as flat buffers of (box_rows*box_cols)^2 cell values in row-major
+//order, 0 for a blank block, the same values as the input files. Classic rules only
+//(square or rectangular boxes up to 64x64); variant rules need the C++ interface.
+//
+//No C++ exception crosses this interface: every failure is reported as a status.
+//A solver handle keeps its storage warm between calls, so reuse one per thread;
+//a handle must not be used by two threads at once.
+
+#if defined(_WIN32)
+	#if defined(SUDOKU_BUILDING_LIBRARY)
+		#define SUDOKU_API __declspec(dllexport)
+	#elif defined(SUDOKU_SHARED)
+		#define SUDOKU_API __declspec(dllimport)
+	#else
+		#define SUDOKU_API
+	#endif
+#else
+	#define SUDOKU_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//Outcome of solving one board
+typedef enum sudoku_status {
+	SUDOKU_SOLVED = 0,
+	SUDOKU_UNSOLVABLE = 1,		//the board has no solution, or its givens already break a rule
+	SUDOKU_TIMED_OUT = 2,		//the search ran past the solver's time limit
+	SUDOKU_BAD_ARGUMENT = 3,	//null pointer, unsupported box shape or a value above size
+	SUDOKU_OUT_OF_MEMORY = 4,
+	SUDOKU_INTERNAL_ERROR = 5
+} sudoku_status;
+
+//Opaque reusable solver
+typedef struct sudoku_solver sudoku_solver;
+
+//EFFECTS: creates a solver, or returns NULL if out of memory
+SUDOKU_API sudoku_solver *sudoku_solver_create(void);
+
+//MODIFIES: solver
+//EFFECTS: frees solver (does nothing for NULL)
+SUDOKU_API void sudoku_solver_destroy(sudoku_solver *solver);
+
+//REQUIRES: solver is not NULL
+//MODIFIES: solver
+//EFFECTS: makes every following solve of a single board give up with SUDOKU_TIMED_OUT
+//		after milliseconds, or lets it run without a limit if milliseconds is 0 (the default)
+SUDOKU_API void sudoku_solver_set_time_limit(sudoku_solver *solver, unsigned long milliseconds);
+
+//REQUIRES: cells points to (box_rows*box_cols)^2 values,
+//			solution points to as many writable values (it may be cells itself)
+//MODIFIES: solver, solution
+//EFFECTS: solves the board in cells and writes its solution to solution if it returns
+//		SUDOKU_SOLVED (solution is left unchanged otherwise)
+SUDOKU_API sudoku_status sudoku_solve(sudoku_solver *solver, unsigned short box_rows, unsigned short box_cols,
+									const unsigned short *cells, unsigned short *solution);
+
+//REQUIRES: cells points to count boards of (box_rows*box_cols)^2 values each, one after the
+//			other, solutions points to as many writable values (it may be cells itself),
+//			statuses points to count writable statuses
+//MODIFIES: solver, solutions, statuses
+//EFFECTS: solves every board, storing the outcome of board i in statuses[i] and its solution
+//		at solutions + i*(box_rows*box_cols)^2 as sudoku_solve() does
+//		returns the number of boards solved
+//		9x9 boards without a time limit are propagated 16 at a time (see Batch_Solver.h)
+SUDOKU_API size_t sudoku_solve_batch(sudoku_solver *solver, unsigned short box_rows, unsigned short box_cols,
+									const unsigned short *cells, size_t count,
+									unsigned short *solutions, sudoku_status *statuses);
+
+//REQUIRES: solver is not NULL
+//EFFECTS: returns the number of search nodes visited by the last sudoku_solve(), or by all
+//		boards of the last sudoku_solve_batch() (9x9 boards finished by propagation visit none)
+SUDOKU_API unsigned long long sudoku_solver_node_count(const sudoku_solver *solver);
+
+//REQUIRES: solver is not NULL
+//EFFECTS: returns a description of the last failure of sudoku_solve() or sudoku_solve_batch()
+//		(empty if there was none), valid until the next call with solver
+SUDOKU_API const char *sudoku_solver_last_error(const sudoku_solver *solver);
+
+//EFFECTS: returns the name of status, e.g. "SUDOKU_SOLVED"
+SUDOKU_API const char *sudoku_status_name(sudoku_status status);
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif
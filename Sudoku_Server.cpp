@@ -0,0 +1,464 @@
+#include "Sudoku_Server.h"
+
+#include <cerrno>
+#include <cstring> //strerror()
+#include <charconv> //to_chars(), from_chars()
+#include <algorithm> //remove_if()
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <unistd.h>
+
+using namespace std;
+
+/*Look at Sudoku_Server.h for documention on member functions' constraints and (side-)effects*/
+
+namespace {
+	//longest request line accepted, enough for a 64x64 board with generous spacing
+	const size_t MAX_LINE_LENGTH = 1 << 20;
+	const size_t READ_CHUNK = 1 << 16;
+	//largest board the server accepts (64x64)
+	const size_t MAX_SIZE = 64;
+	//how often run() wakes up to check whether stop() was called
+	const int ACCEPT_POLL_MS = 200;
+
+	bool is_space(char c) {
+		return c == ' ' || c == '\t' || c == '\r';
+	}
+
+	//EFFECTS: skips whitespace from pos and returns the next token as [begin, end)
+	//		returns false if there is no token before line_end
+	bool next_token(const char *&pos, const char *line_end, const char *&begin, const char *&end) {
+		while (pos != line_end && is_space(*pos)) {
+			++pos;
+		}
+		if (pos == line_end) {
+			return false;
+		}
+		begin = pos;
+		while (pos != line_end && !is_space(*pos)) {
+			++pos;
+		}
+		end = pos;
+		return true;
+	}
+
+	//EFFECTS: parses [begin, end) as an unsigned short, returns false if it is not one
+	bool parse_ushort(const char *begin, const char *end, unsigned short &out) {
+		auto result = from_chars(begin, end, out);
+		return result.ec == errc() && result.ptr == end;
+	}
+
+	//EFFECTS: parses [begin, end) as a box shape, either small_size or box_rows'x'box_cols
+	//		returns false if it is neither or describes an empty or too large board
+	bool parse_box_shape(const char *begin, const char *end,
+						unsigned short &box_rows, unsigned short &box_cols) {
+		auto result = from_chars(begin, end, box_rows);
+		if (result.ec != errc()) {
+			return false;
+		} else if (result.ptr == end) {
+			box_cols = box_rows;
+		} else if (*result.ptr != 'x' || !parse_ushort(result.ptr + 1, end, box_cols)) {
+			return false;
+		}
+		size_t size = (size_t) box_rows * box_cols;
+		return size != 0 && size <= MAX_SIZE;
+	}
+
+	//EFFECTS: appends " ERROR <msg>" to out as a single line
+	void append_error(string &out, const string &msg) {
+		out.append(" ERROR ");
+		for (char c : msg) {
+			out.push_back(c == '\n' ? ' ' : c);
+		}
+		out.push_back('\n');
+	}
+
+	void append_number(string &out, unsigned short val) {
+		char buf[8];
+		auto result = to_chars(buf, buf + sizeof(buf), val);
+		out.append(buf, result.ptr);
+	}
+}
+
+
+Server_Error::Server_Error(const string &what, int err) {
+	msg = "Sudoku_Server: " + what + ": " + strerror(err);
+}
+
+
+Sudoku_Server::Connection::~Connection() {
+	close(fd);
+}
+
+
+bool Sudoku_Server::Connection::send_all(const char *data, size_t len) {
+	lock_guard<mutex> lock(write_mutex);
+	while (len > 0) {
+		ssize_t sent = send(fd, data, len, MSG_NOSIGNAL);
+		if (sent < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return false;
+		}
+		data += sent;
+		len -= (size_t) sent;
+	}
+	return true;
+}
+
+
+Sudoku_Server::Sudoku_Server(const Server_Config &config_in)
+	: config(config_in) {
+	if (config.num_workers == 0) {
+		config.num_workers = 1;
+	}
+	if (config.queue_capacity == 0) {
+		config.queue_capacity = 1;
+	}
+	if (config.cache_bytes != 0) {
+		cache.reset(new Solution_Cache(config.cache_bytes, config.cache_path));
+	}
+}
+
+
+Sudoku_Server::~Sudoku_Server() {
+	stop();
+}
+
+
+void Sudoku_Server::stop() {
+	running = false;
+}
+
+
+void Sudoku_Server::open_listen_socket() {
+	if (!config.unix_path.empty()) {
+		sockaddr_un addr{};
+		addr.sun_family = AF_UNIX;
+		if (config.unix_path.size() >= sizeof(addr.sun_path)) {
+			throw Server_Error("unix socket path too long", ENAMETOOLONG);
+		}
+		memcpy(addr.sun_path, config.unix_path.c_str(), config.unix_path.size() + 1);
+
+		listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+		if (listen_fd < 0) {
+			throw Server_Error("socket", errno);
+		}
+		unlink(config.unix_path.c_str()); //remove stale socket from a previous run
+		if (bind(listen_fd, (sockaddr *) &addr, sizeof(addr)) < 0) {
+			int err = errno;
+			close(listen_fd);
+			throw Server_Error("bind " + config.unix_path, err);
+		}
+	} else {
+		sockaddr_in addr{};
+		addr.sin_family = AF_INET;
+		addr.sin_port = htons(config.tcp_port);
+		addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+		listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+		if (listen_fd < 0) {
+			throw Server_Error("socket", errno);
+		}
+		int one = 1;
+		setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+		if (bind(listen_fd, (sockaddr *) &addr, sizeof(addr)) < 0) {
+			int err = errno;
+			close(listen_fd);
+			throw Server_Error("bind 127.0.0.1:" + to_string(config.tcp_port), err);
+		}
+	}
+
+	if (listen(listen_fd, SOMAXCONN) < 0) {
+		int err = errno;
+		close(listen_fd);
+		throw Server_Error("listen", err);
+	}
+}
+
+
+void Sudoku_Server::run() {
+	open_listen_socket();
+	running = true;
+	queue_closed = false;
+
+	for (size_t i = 0; i < config.num_workers; ++i) {
+		workers.emplace_back(&Sudoku_Server::worker_loop, this);
+	}
+
+	pollfd pfd{listen_fd, POLLIN, 0};
+	while (running) {
+		if (poll(&pfd, 1, ACCEPT_POLL_MS) <= 0) {
+			continue; //timeout or EINTR, check running again
+		}
+		int fd = accept(listen_fd, nullptr, nullptr);
+		if (fd < 0) {
+			continue;
+		}
+		auto conn = make_shared<Connection>(fd);
+		lock_guard<mutex> lock(conn_mutex);
+		//forget connections that have been closed and fully answered
+		connections.erase(remove_if(connections.begin(), connections.end(),
+				[](const weak_ptr<Connection> &weak_conn) { return weak_conn.expired(); }),
+				connections.end());
+		connections.push_back(conn);
+		++active_readers;
+		thread(&Sudoku_Server::read_loop, this, conn).detach();
+	}
+
+	close(listen_fd);
+	if (!config.unix_path.empty()) {
+		unlink(config.unix_path.c_str());
+	}
+
+	//wake up readers blocked in recv() or push_job() and wait for them
+	{
+		lock_guard<mutex> lock(conn_mutex);
+		for (auto &weak_conn : connections) {
+			if (auto conn = weak_conn.lock()) {
+				shutdown(conn->fd, SHUT_RD);
+			}
+		}
+	}
+	{
+		lock_guard<mutex> lock(queue_mutex);
+		queue_closed = true;
+	}
+	queue_not_empty.notify_all();
+	queue_not_full.notify_all();
+	{
+		unique_lock<mutex> lock(conn_mutex);
+		readers_done.wait(lock, [this] { return active_readers == 0; });
+	}
+	for (auto &worker : workers) {
+		worker.join();
+	}
+	workers.clear();
+	connections.clear();
+	queue.clear();
+
+	if (cache) {
+		try {
+			cache->save(); //drop evicted entries from the file
+		} catch (Cache_Error &) {
+			//the appended file is still complete, only larger than needed
+		}
+	}
+}
+
+
+void Sudoku_Server::read_loop(shared_ptr<Connection> conn) {
+	vector<char> buffer;
+	buffer.reserve(READ_CHUNK);
+	size_t line_start = 0;
+
+	while (true) {
+		size_t old_size = buffer.size();
+		buffer.resize(old_size + READ_CHUNK);
+		ssize_t got = recv(conn->fd, buffer.data() + old_size, READ_CHUNK, 0);
+		if (got < 0 && errno == EINTR) {
+			buffer.resize(old_size);
+			continue;
+		} else if (got <= 0) {
+			break; //peer closed the connection or server is shutting down
+		}
+		buffer.resize(old_size + (size_t) got);
+
+		//hand every complete line to handle_line()
+		size_t scan = old_size;
+		for (; scan < buffer.size(); ++scan) {
+			if (buffer[scan] == '\n') {
+				handle_line(conn, buffer.data() + line_start, buffer.data() + scan);
+				line_start = scan + 1;
+			}
+		}
+
+		if (buffer.size() - line_start > MAX_LINE_LENGTH) {
+			const char reply[] = "- ERROR request line too long\n";
+			conn->send_all(reply, sizeof(reply) - 1);
+			break;
+		}
+
+		//keep only the incomplete tail of the last line
+		buffer.erase(buffer.begin(), buffer.begin() + (ptrdiff_t) line_start);
+		line_start = 0;
+	}
+
+	conn.reset();
+	lock_guard<mutex> lock(conn_mutex);
+	--active_readers;
+	readers_done.notify_all();
+}
+
+
+void Sudoku_Server::handle_line(const shared_ptr<Connection> &conn, const char *begin, const char *end) {
+	const char *pos = begin;
+	const char *tok_begin;
+	const char *tok_end;
+
+	if (!next_token(pos, end, tok_begin, tok_end)) {
+		return; //blank line
+	}
+
+	auto job = acquire_job();
+	job->id.assign(tok_begin, tok_end);
+
+	const char *error = nullptr;
+	if (!next_token(pos, end, tok_begin, tok_end)
+		|| !parse_box_shape(tok_begin, tok_end, job->box_rows, job->box_cols)) {
+		error = "invalid box shape";
+	} else {
+		size_t size = (size_t) job->box_rows * job->box_cols;
+		size_t count = size * size;
+		job->vals.resize(count);
+		for (size_t i = 0; i < count; ++i) {
+			if (!next_token(pos, end, tok_begin, tok_end)) {
+				error = "too few values";
+				break;
+			} else if (!parse_ushort(tok_begin, tok_end, job->vals[i]) || job->vals[i] > size) {
+				error = "invalid value";
+				break;
+			}
+		}
+		if (error == nullptr && next_token(pos, end, tok_begin, tok_end)) {
+			error = "too many values";
+		}
+	}
+
+	if (error != nullptr) {
+		string reply = job->id + " ERROR " + error + "\n";
+		conn->send_all(reply.data(), reply.size());
+		release_job(move(job));
+		return;
+	}
+
+	job->conn = conn;
+	if (config.timeout_ms != 0) {
+		job->deadline = chrono::steady_clock::now() + chrono::milliseconds(config.timeout_ms);
+	}
+	push_job(move(job));
+}
+
+
+void Sudoku_Server::worker_loop() {
+	Sudoku_Solver solver(0, nullptr); //warm solver, reloaded for every job
+	string reply;
+	vector<unsigned short> solution;
+
+	while (auto job = pop_job()) {
+		reply.assign(job->id);
+
+		if (config.timeout_ms != 0 && chrono::steady_clock::now() > job->deadline) {
+			reply.append(" TIMEOUT\n"); //expired while waiting in the queue
+		} else {
+			try {
+				solver.load(job->box_rows, job->box_cols, job->vals.data()); //validates vals
+				unsigned short size = solver.get_size();
+				solution.resize((size_t) size * size);
+
+				unique_ptr<Canonical_Form> form;
+				bool solved = false;
+				if (cache) {
+					form.reset(new Canonical_Form(job->box_rows, job->box_cols, job->vals.data()));
+					solved = cache->lookup(*form, solution.data());
+				}
+				if (!solved) {
+					if (config.timeout_ms != 0) {
+						solver.set_deadline(job->deadline);
+					}
+					solved = solver.solve();
+					if (solved) {
+						for (unsigned short row = 0; row < size; ++row) {
+							for (unsigned short col = 0; col < size; ++col) {
+								solution[(size_t) row * size + col] = solver.get_val(row, col);
+							}
+						}
+						if (cache) {
+							cache->insert(*form, solution.data());
+						}
+					}
+				}
+
+				if (solved) {
+					reply.append(" OK");
+					for (auto val : solution) {
+						reply.push_back(' ');
+						append_number(reply, val);
+					}
+					reply.push_back('\n');
+				} else {
+					reply.append(" UNSOLVABLE\n");
+				}
+			} catch (Sudoku_Error &) {
+				reply.append(" UNSOLVABLE\n");
+			} catch (Timeout_Error &) {
+				reply.append(" TIMEOUT\n");
+			} catch (Value_Error &err) {
+				append_error(reply, err.msg);
+			} catch (Coordinate_Error &err) {
+				append_error(reply, err.msg);
+			}
+		}
+
+		job->conn->send_all(reply.data(), reply.size());
+		release_job(move(job));
+	}
+}
+
+
+unique_ptr<Sudoku_Server::Job> Sudoku_Server::acquire_job() {
+	{
+		lock_guard<mutex> lock(queue_mutex);
+		if (!free_jobs.empty()) {
+			auto job = move(free_jobs.back());
+			free_jobs.pop_back();
+			return job;
+		}
+	}
+	return unique_ptr<Job>(new Job());
+}
+
+
+bool Sudoku_Server::push_job(unique_ptr<Job> job) {
+	unique_lock<mutex> lock(queue_mutex);
+	queue_not_full.wait(lock, [this] {
+		return queue_closed || queue.size() < config.queue_capacity;
+	});
+	if (queue_closed) {
+		job->conn.reset();
+		free_jobs.push_back(move(job));
+		return false;
+	}
+	queue.push_back(move(job));
+	lock.unlock();
+	queue_not_empty.notify_one();
+	return true;
+}
+
+
+unique_ptr<Sudoku_Server::Job> Sudoku_Server::pop_job() {
+	unique_lock<mutex> lock(queue_mutex);
+	queue_not_empty.wait(lock, [this] {
+		return queue_closed || !queue.empty();
+	});
+	if (queue.empty()) {
+		return nullptr; //closed and drained
+	}
+	auto job = move(queue.front());
+	queue.pop_front();
+	lock.unlock();
+	queue_not_full.notify_one();
+	return job;
+}
+
+
+void Sudoku_Server::release_job(unique_ptr<Job> job) {
+	job->conn.reset(); //drop the reference so closed connections can be freed
+	lock_guard<mutex> lock(queue_mutex);
+	free_jobs.push_back(move(job));
+}
@@ -0,0 +1,160 @@
+#ifndef SUDOKU_SERVER_H
+#define SUDOKU_SERVER_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <chrono>
+
+#include "Sudoku_Solver.h"
+#include "Solution_Cache.h"
+
+//Settings for Sudoku_Server
+//exactly one of unix_path (non-empty) or tcp_port (non-zero) selects the listening socket
+struct Server_Config {
+	std::string unix_path;
+	unsigned short tcp_port = 0; //bound to 127.0.0.1 only
+	size_t num_workers = 4;
+	//max number of requests waiting for a worker, readers stop reading when it is full
+	size_t queue_capacity = 1024;
+	//time a request may spend queued and solving before TIMEOUT is returned, 0 disables
+	unsigned int timeout_ms = 10000;
+	//memory limit of the solution cache shared by all workers, 0 disables the cache
+	size_t cache_bytes = 0;
+	//file the solution cache is loaded from and saved to, empty keeps it in memory only
+	std::string cache_path;
+};
+
+//A long-running solve daemon that listens on a unix domain socket or localhost tcp port.
+//
+//Protocol (one request per line, any number of requests may be pipelined):
+//	request:  <id> <boxes> <v1> <v2> ... <v(size^2)>
+//	response: <id> OK <v1> <v2> ... <v(size^2)>
+//	          <id> UNSOLVABLE
+//	          <id> TIMEOUT
+//	          <id> ERROR <message>
+//where <id> is any token without whitespace chosen by the client, <boxes> is small_size
+//for square boxes or box_rows'x'box_cols (e.g. 2x3) for rectangular ones, and 0 marks a blank block.
+//Responses are written as soon as each puzzle is done, so they may arrive out of order;
+//clients match them up by <id>.
+//
+//Each worker thread keeps one Sudoku_Solver alive and reloads it for every request,
+//and request buffers are recycled, so steady-state solving does no process startup
+//and (almost) no allocation.
+//
+//With a solution cache, repeated puzzles (also relabelled, with rows or columns swapped,
+//or rotated) are answered from the cache without solving them again.
+class Sudoku_Server {
+public:
+	//MODIFIES: config, cache
+	//EFFECTS: creates a server, does not open any socket yet
+	//		throws Cache_Error() if the cache file cannot be used
+	Sudoku_Server(const Server_Config &config_in);
+
+	//REQUIRES: run() is not executing
+	~Sudoku_Server();
+
+	Sudoku_Server(const Sudoku_Server &) = delete;
+	Sudoku_Server &operator=(const Sudoku_Server &) = delete;
+
+	//MODIFIES: all server state
+	//EFFECTS: opens the listening socket, starts the workers and serves connections
+	//		until stop() is called, then closes all connections and returns
+	//		throws Server_Error() if the socket cannot be set up
+	void run();
+
+	//MODIFIES: running
+	//EFFECTS: asks run() to return, safe to call from any thread
+	void stop();
+
+private:
+	//One client connection, shared by its reader thread and any worker holding one of its jobs
+	struct Connection {
+		explicit Connection(int fd_in) : fd{fd_in} {}
+		~Connection();
+
+		//EFFECTS: writes all of data to the socket, serialized with other writers
+		//		returns false if the peer has gone away
+		bool send_all(const char *data, size_t len);
+
+		int fd;
+		std::mutex write_mutex;
+	};
+
+	//A parsed request, recycled through free_jobs to avoid per-request allocation
+	struct Job {
+		std::shared_ptr<Connection> conn;
+		std::string id;
+		unsigned short box_rows;
+		unsigned short box_cols;
+		std::vector<unsigned short> vals;
+		std::chrono::steady_clock::time_point deadline;
+	};
+
+	Server_Config config;
+	std::atomic<bool> running{false};
+	int listen_fd = -1;
+
+	//bounded job queue shared by all readers and workers
+	std::mutex queue_mutex;
+	std::condition_variable queue_not_empty;
+	std::condition_variable queue_not_full;
+	std::deque<std::unique_ptr<Job> > queue;
+	std::vector<std::unique_ptr<Job> > free_jobs;
+	bool queue_closed = false;
+
+	std::vector<std::thread> workers;
+
+	//solutions of earlier requests, null if config.cache_bytes is 0
+	std::unique_ptr<Solution_Cache> cache;
+
+	//reader threads are detached, run() waits for active_readers to drop to 0 on shutdown
+	std::mutex conn_mutex;
+	std::condition_variable readers_done;
+	size_t active_readers = 0;
+	std::vector<std::weak_ptr<Connection> > connections;
+
+	//EFFECTS: opens, binds and listens on the socket described by config
+	void open_listen_socket();
+
+	//EFFECTS: reads requests from conn until it closes and queues them for the workers
+	void read_loop(std::shared_ptr<Connection> conn);
+
+	//EFFECTS: parses one request line into a job and queues it,
+	//		or writes an ERROR response to conn if the line is malformed
+	void handle_line(const std::shared_ptr<Connection> &conn, const char *begin, const char *end);
+
+	//EFFECTS: pops jobs and solves them with a warm solver until the queue is closed
+	void worker_loop();
+
+	//EFFECTS: returns a cleared job from free_jobs, or a new one if none are free
+	std::unique_ptr<Job> acquire_job();
+
+	//REQUIRES: queue is not closed
+	//EFFECTS: blocks while the queue is full (back pressure on the reader), then queues job
+	//		returns false if the server is shutting down
+	bool push_job(std::unique_ptr<Job> job);
+
+	//EFFECTS: blocks until a job is available and returns it, or nullptr once the queue is closed
+	std::unique_ptr<Job> pop_job();
+
+	//EFFECTS: returns job to free_jobs for reuse
+	void release_job(std::unique_ptr<Job> job);
+};
+
+
+//Exception thrown when the server cannot set up its listening socket
+class Server_Error {
+public:
+	Server_Error(const std::string &what, int err);
+
+	std::string msg;
+};
+
+
+#endif
@@ -1,33 +1,362 @@
 #include "Sudoku.h"
 #include "Sudoku_Solver.h"
+#include "Search_Recorder.h"
+#include "Allocation_Counter.h"
+
+#include <cassert>
+#include <cstdio> //rename()
+#include <cstring> //memcmp(), memcpy()
+#include <fstream>
 
 using namespace std;
 
 /*Look at Sudoku_Solver.h for documention on member functions' constraints and (side-)effects*/
 
+namespace {
+	const unsigned char CHECKPOINT_MAGIC[4] = {'S', 'D', 'K', 'P'};
+	const unsigned char CHECKPOINT_VERSION = 2;
+	const size_t CHECKPOINT_HEADER_BYTES = 8;
+}
+
+//classic (false) and variant (true) propagation are specialised below
+template <>
+void Sudoku_Solver::set_val_and_update<false>(unsigned short row, unsigned short col, unsigned short val);
+template <>
+void Sudoku_Solver::set_val_and_update<true>(unsigned short row, unsigned short col, unsigned short val);
+template <>
+void Sudoku_Solver::unset_val_and_update<false>(unsigned short row, unsigned short col);
+template <>
+void Sudoku_Solver::unset_val_and_update<true>(unsigned short row, unsigned short col);
+
 Sudoku_Solver::Sudoku_Solver(istream &is)
 	: sudoku(is) {
 	size = sudoku.get_size();
-	tracker.resize(size);
+	reserve_search();
+}
+
+
+Sudoku_Solver::Sudoku_Solver(unsigned short small_size, const unsigned short *vals)
+	: sudoku(small_size, vals) {
+	size = sudoku.get_size();
+	reserve_search();
+}
+
+
+Sudoku_Solver::Sudoku_Solver(unsigned short box_rows, unsigned short box_cols, const unsigned short *vals)
+	: sudoku(box_rows, box_cols, vals) {
+	size = sudoku.get_size();
+	reserve_search();
+}
+
+
+Sudoku_Solver::Sudoku_Solver(const Board_Archive &archive, size_t index)
+	: sudoku(archive, index) {
+	size = sudoku.get_size();
+	reserve_search();
+}
+
+
+void Sudoku_Solver::load(unsigned short small_size, const unsigned short *vals) {
+	load(small_size, small_size, vals);
+}
+
+
+void Sudoku_Solver::load(unsigned short box_rows, unsigned short box_cols, const unsigned short *vals) {
+	sudoku.load(box_rows, box_cols, vals);
+	size = sudoku.get_size();
+	reserve_search();
+	nodes = 0;
+	moves.clear();
+	moves_started = false;
+}
+
+
+void Sudoku_Solver::load(const Board_Archive &archive, size_t index) {
+	sudoku.load(archive, index);
+	size = sudoku.get_size();
+	reserve_search();
+	nodes = 0;
+	moves.clear();
+	moves_started = false;
+}
+
+
+void Sudoku_Solver::set_model(const Constraint_Model &model) {
+	sudoku.set_model(model);
+	moves.clear();
+	moves_started = false; //domains depend on the rules
+}
+
+
+void Sudoku_Solver::reserve_search() {
+	size_t num_blocks = (size_t) size * size;
+	tracker.assign(size, make_pair(0, 0));
+	cumulative_conflicts.assign(num_blocks, Block::BLANK);
+	//one decision per depth, and every node fills a blank block
+	decisions.resize(num_blocks);
+	singles.reserve(num_blocks);
+	given.resize(num_blocks);
+}
+
+
+void Sudoku_Solver::start_moves() {
+	if (moves_started) {
+		return;
+	}
+	sudoku.update_all_domains();
+	for (unsigned short i = 0; i < size; ++i) {
+		track_row(i);
+	}
+	moves_started = true;
+}
+
+
+void Sudoku_Solver::apply_move(unsigned short row, unsigned short col, unsigned short val) {
+	start_moves();
+	if (row >= size || col >= size) {
+		throw Coordinate_Error("Sudoku_Solver::apply_move", row, col, size);
+	} else if (sudoku.get_val(row, col) != Block::BLANK
+		|| val == Block::BLANK || val > size
+		|| (sudoku.get_domain(row, col) & domain_bit(val)) == 0) {
+		throw Move_Error(row, col, val);
+	}
+
+	if (sudoku.get_model().is_classic()) {
+		set_val_and_update<false>(row, col, val);
+	} else {
+		set_val_and_update<true>(row, col, val);
+	}
+	moves.push_back(make_pair(row, col));
 }
 
 
-bool Sudoku_Solver::solve_helper(std::unordered_map<unsigned short, unsigned short> &cumulative_conflict_set, size_t depth) {
+bool Sudoku_Solver::undo_move() {
+	if (moves.empty()) {
+		return false;
+	}
+
+	//moves are taken back in reverse order, like the search backtracks,
+	//so every conflict set entry a move added is still in place
+	auto move = moves.back();
+	moves.pop_back();
+	if (sudoku.get_model().is_classic()) {
+		unset_val_and_update<false>(move.first, move.second);
+	} else {
+		unset_val_and_update<true>(move.first, move.second);
+	}
+	return true;
+}
+
+
+size_t Sudoku_Solver::get_num_moves() const {
+	return moves.size();
+}
+
+
+Domain_Mask Sudoku_Solver::candidates(unsigned short row, unsigned short col) {
+	start_moves();
+	if (sudoku.get_val(row, col) != Block::BLANK) {
+		return 0;
+	}
+	return sudoku.get_domain(row, col);
+}
+
+
+Hint Sudoku_Solver::next_hint() {
+	start_moves();
+	Hint hint;
+
+	//a block with no values left makes every other step pointless
+	//a block with one value left is the easiest step to explain
+	for (int pass = 0; pass < 2; ++pass) {
+		unsigned short wanted = (unsigned short) pass; //domain size looked for
+		for (unsigned short row = 0; row < size; ++row) {
+			if (tracker[row].second > wanted) {
+				continue; //tracker holds the smallest domain of each row
+			}
+			for (unsigned short col = 0; col < size; ++col) {
+				if (sudoku.get_val(row, col) != Block::BLANK
+					|| sudoku.get_domain_size(row, col) != wanted) {
+					continue;
+				}
+				Domain_Mask domain = sudoku.get_domain(row, col);
+				hint.technique = (wanted == 0) ? Hint_Technique::CONTRADICTION : Hint_Technique::NAKED_SINGLE;
+				hint.row = row;
+				hint.col = col;
+				hint.val = (wanted == 0) ? Block::BLANK : domain_first(domain);
+				//explain every value that is gone by a peer holding it
+				for (unsigned short val = 1; val <= size; ++val) {
+					if (domain & domain_bit(val)) {
+						continue;
+					}
+					auto holder = find_holder(row, col, val);
+					if (holder.first != size) {
+						hint.cells.push_back(holder);
+					}
+				}
+				return hint;
+			}
+		}
+	}
+
+	find_hidden_single(hint);
+	return hint;
+}
+
+
+pair<unsigned short, unsigned short> Sudoku_Solver::find_holder(unsigned short row, unsigned short col,
+																unsigned short val) const {
+	const Constraint_Model &model = sudoku.get_model();
+	if (!model.is_classic()) {
+		unsigned short key = sudoku.get_key(row, col);
+		for (auto peer = model.peers_begin(key); peer != model.peers_end(key); ++peer) {
+			unsigned short i = (unsigned short) (*peer / size);
+			unsigned short j = (unsigned short) (*peer % size);
+			if (sudoku.get_val(i, j) == val) {
+				return make_pair(i, j);
+			}
+		}
+		return make_pair(size, size);
+	}
+
+	for (unsigned short i = 0; i < size; ++i) {
+		if (sudoku.get_val(i, col) == val) {
+			return make_pair(i, col);
+		}
+	}
+	for (unsigned short j = 0; j < size; ++j) {
+		if (sudoku.get_val(row, j) == val) {
+			return make_pair(row, j);
+		}
+	}
+	auto box_rows = sudoku.get_box_rows();
+	auto box_cols = sudoku.get_box_cols();
+	unsigned short start_row = (unsigned short) (row - row%box_rows);
+	unsigned short start_col = (unsigned short) (col - col%box_cols);
+	for (unsigned short i = start_row; i < start_row + box_rows; ++i) {
+		for (unsigned short j = start_col; j < start_col + box_cols; ++j) {
+			if (sudoku.get_val(i, j) == val) {
+				return make_pair(i, j);
+			}
+		}
+	}
+	return make_pair(size, size);
+}
+
+
+bool Sudoku_Solver::find_hidden_single(Hint &hint) const {
+	const Constraint_Model &model = sudoku.get_model();
+	size_t num_units = model.is_classic() ? (size_t) 3 * size : model.get_num_units();
+	auto box_rows = sudoku.get_box_rows();
+	auto box_cols = sudoku.get_box_cols();
+	vector<unsigned short> unit;
+
+	for (size_t index = 0; index < num_units; ++index) {
+		//cols, rows, then squares, the same order Constraint_Model lists units in
+		unit.clear();
+		if (!model.is_classic()) {
+			unit = model.get_unit(index);
+			if (unit.size() != size) {
+				continue; //only a unit of size blocks must hold every value
+			}
+		} else if (index < size) {
+			for (unsigned short i = 0; i < size; ++i) {
+				unit.push_back(sudoku.get_key(i, (unsigned short) index));
+			}
+		} else if (index < 2 * (size_t) size) {
+			for (unsigned short j = 0; j < size; ++j) {
+				unit.push_back(sudoku.get_key((unsigned short) (index - size), j));
+			}
+		} else {
+			unsigned short square = (unsigned short) (index - 2 * (size_t) size);
+			unsigned short start_row = (unsigned short) ((square/box_rows)*box_rows);
+			unsigned short start_col = (unsigned short) ((square%box_rows)*box_cols);
+			for (unsigned short i = start_row; i < start_row + box_rows; ++i) {
+				for (unsigned short j = start_col; j < start_col + box_cols; ++j) {
+					unit.push_back(sudoku.get_key(i, j));
+				}
+			}
+		}
+
+		//seen: values in some blank domain, repeated: values in two or more
+		Domain_Mask seen = 0;
+		Domain_Mask repeated = 0;
+		Domain_Mask filled = 0;
+		for (auto block : unit) {
+			unsigned short i = (unsigned short) (block / size);
+			unsigned short j = (unsigned short) (block % size);
+			if (sudoku.get_val(i, j) != Block::BLANK) {
+				filled |= domain_bit(sudoku.get_val(i, j));
+				continue;
+			}
+			Domain_Mask domain = sudoku.get_domain(i, j);
+			repeated |= seen & domain;
+			seen |= domain;
+		}
+		Domain_Mask once = seen & ~repeated & ~filled;
+		if (once == 0) {
+			continue;
+		}
+
+		unsigned short val = domain_first(once);
+		hint.technique = Hint_Technique::HIDDEN_SINGLE;
+		hint.val = val;
+		for (auto block : unit) {
+			unsigned short i = (unsigned short) (block / size);
+			unsigned short j = (unsigned short) (block % size);
+			if (sudoku.get_val(i, j) != Block::BLANK) {
+				continue;
+			} else if (sudoku.get_domain(i, j) & domain_bit(val)) {
+				hint.row = i;
+				hint.col = j;
+			} else {
+				hint.cells.push_back(make_pair(i, j));
+			}
+		}
+		return true;
+	}
+	return false;
+}
+
+
+template <bool Variant>
+bool Sudoku_Solver::solve_helper(std::vector<unsigned short> &cumulative_conflict_set, size_t depth) {
+	//a node entered before the checkpoint being resumed was saved is rebuilt from its
+	//decision: its block is known and its current value is already on the board
+	bool resuming = depth < resume_depth;
+	if (!resuming) {
+		resume_depth = 0;
+		++nodes;
+		if ((has_deadline || has_checkpoint) && nodes % CLOCK_CHECK_INTERVAL == 0) {
+			check_clock(cumulative_conflict_set, depth);
+		}
+	}
+
+	size_t first_node = nodes - 1;
+	bool recorded = !resuming && recorder != nullptr && recorder->enter(depth);
+	Node_Record record;
+	record.depth = (unsigned short) depth;
+
 	//find block with smallest domain
 	unsigned short row = (unsigned short) size; //temporary place holder
 	unsigned short col = (unsigned short) size; //temporary place holder
 	unsigned short min_domain_size = (unsigned short) (size+1); //temporary place holder
-	for (unsigned short i = 0; i < size; ++i) {
+	for (unsigned short i = 0; !resuming && i < size; ++i) {
 		auto domain_size = tracker[i].second;
 		if (domain_size == 0) {
 			//found conflict
 			row = i;
 			col = tracker[i].first;
 
-			auto &cs = sudoku.get_conflict_set(row, col);
 			//cumulative_conflict_set.clear(); //DO NOT clear conflict_set, all conflicts matter!
-			for (auto it = cs.begin(); it != cs.end(); ++it) {
-				cumulative_conflict_set[it->first] = it->second;
+			merge_conflict_set(cumulative_conflict_set, row, col);
+			if (recorder != nullptr) {
+				recorder->fail(depth, row, col);
+				if (recorded) {
+					record.row = row;
+					record.col = col;
+					leave_node(record, Node_Outcome::DEAD_END, first_node);
+				}
 			}
 			return false;
 
@@ -38,36 +367,79 @@ bool Sudoku_Solver::solve_helper(std::unordered_map<unsigned short, unsigned sho
 		}
 	}
 
+	if (resuming) {
+		row = decisions[depth].row;
+		col = decisions[depth].col;
+	}
 	unsigned short key = sudoku.get_key(row, col);
+	record.row = row;
+	record.col = col;
+	record.domain_size = min_domain_size;
 
 	//assign value and continue search
-	auto &domain = sudoku.get_domain(row, col);
-	for (auto it = domain.begin(); it != domain.end(); ++it) {
-		set_val_and_update(row, col, *it);
+	//(the domain of a block is not modified while the block holds a value)
+	Domain_Mask domain = resuming ? decisions[depth].domain : sudoku.get_domain(row, col);
+	//(values are tried from the largest down, the order the original set-based domains gave)
+	for (; domain != 0; domain &= ~domain_bit(domain_last(domain))) {
+		unsigned short val = domain_last(domain);
+		if (resuming) {
+			resuming = false; //val is on the board already, carry on below it
+		} else {
+			set_val_and_update<Variant>(row, col, val);
+			record.values_tried |= domain_bit(val);
 
-		//stop search when sudoku board is full (which is entirely through legel moves)
-		if (sudoku.get_num_blank() == 0) {
-			return true;
+			//a killer cage that can no longer reach its sum rules val out like an empty domain would
+			if (Variant && cage_conflict(cumulative_conflict_set, row, col)) {
+				unset_val_and_update<Variant>(row, col); //undo
+				continue;
+			}
+
+			//stop search when sudoku board is full (which is entirely through legel moves)
+			if (sudoku.get_num_blank() == 0) {
+				if (recorded) {
+					leave_node(record, Node_Outcome::SOLVED, first_node);
+				}
+				return true;
+			}
+		}
+
+		if (has_checkpoint) {
+			decisions[depth] = Decision{row, col, domain};
 		}
 
 		//if conflict was found in the next iteration
 		//or if next iteration could not solve conflict
-		if (solve_helper(cumulative_conflict_set, depth+1) == false) {
-			unset_val_and_update(row, col); //undo
+		++record.children;
+		if (solve_helper<Variant>(cumulative_conflict_set, depth+1) == false) {
+			unset_val_and_update<Variant>(row, col); //undo
 			//if current block's key and val is in cumulative conflict set
-			auto ccs_it = cumulative_conflict_set.find(key);
-			if (ccs_it != cumulative_conflict_set.end() && ccs_it->second == *it) {
+			if (cumulative_conflict_set[key] == val) {
 				//if erase here, little less memory overhead but slower speed
 				//cumulative_conflict_set.erase(key);
+				if (recorder != nullptr) {
+					recorder->land(depth, row, col);
+				}
 				continue; //continue search with next value
 			} else {
+				if (recorded) {
+					leave_node(record, Node_Outcome::SKIPPED, first_node);
+				}
 				return false; //move back up a depth
 			}
 		} else {
+			if (recorded) {
+				leave_node(record, Node_Outcome::SOLVED, first_node);
+			}
 			return true; //propagate return true from when board is full
 		}
 	}
 
+	if (recorder != nullptr) {
+		recorder->fail(depth, row, col);
+		if (recorded) {
+			leave_node(record, Node_Outcome::EXHAUSTED, first_node);
+		}
+	}
 	if (depth == 0) {
 		//i.e. current block is initial block the search started with
 		throw Sudoku_Error(); //exhausted search space
@@ -75,50 +447,125 @@ bool Sudoku_Solver::solve_helper(std::unordered_map<unsigned short, unsigned sho
 		//current block was in cumulative_conflict_set,
 		//but all its values led to a conflict.
 		//if erase here, little more memory overhead but faster speed
-		cumulative_conflict_set.erase(key);
-		auto &cs = sudoku.get_conflict_set(row, col);
-		for (auto it = cs.begin(); it != cs.end(); ++it) {
-			cumulative_conflict_set[it->first] = it->second;
-		}
+		cumulative_conflict_set[key] = Block::BLANK;
+		merge_conflict_set(cumulative_conflict_set, row, col);
 		return false;
 	}
 }
 
 
+void Sudoku_Solver::leave_node(Node_Record &record, Node_Outcome outcome, size_t first_node) {
+	record.outcome = outcome;
+	record.subtree_nodes = nodes - first_node;
+	recorder->leave(record);
+}
+
+
 bool Sudoku_Solver::solve() {
-	if (sudoku.is_solved()) {
-		return true; //sudoku is already solved
-	} else if (sudoku.get_num_blank() == 0) {
-		throw Sudoku_Error(); //sudoku is invalid
+	size_t allocations = Allocation_Counter::count;
+	bool solved = solve_board();
+	//checkpoints and the recorder write files and records, everything else runs on the
+	//storage reserve_search() set aside when the board was loaded
+	assert(has_checkpoint || recorder != nullptr || Allocation_Counter::count == allocations);
+	(void) allocations;
+	return solved;
+}
+
+
+bool Sudoku_Solver::solve_board() {
+	moves.clear(); //the search may overwrite any block
+	moves_started = false;
+	if (recorder != nullptr) {
+		recorder->begin(sudoku.get_box_rows(), sudoku.get_box_cols());
 	}
 
-	//check sudoku is valid
-	pre_check();
+	//classic boards use the hard-coded row/col/box loops
+	bool variant = !sudoku.get_model().is_classic();
 
-	//solve sudoku until CBJ algorithm is needed
-	pre_solve();
+	if (resume_pending) {
+		//the checkpoint was saved mid-search, long after pre_solve()
+		resume_pending = false;
+	} else {
+		nodes = 0;
+		resume_depth = 0;
+		if (has_checkpoint) {
+			for (unsigned short row = 0; row < size; ++row) {
+				for (unsigned short col = 0; col < size; ++col) {
+					given[sudoku.get_key(row, col)] = sudoku.get_val(row, col);
+				}
+			}
+		}
 
-	if (sudoku.is_solved()) {
-		return true;
+		if (sudoku.is_solved()) {
+			return true; //sudoku is already solved
+		} else if (sudoku.get_num_blank() == 0) {
+			throw Sudoku_Error(); //sudoku is invalid
+		}
+
+		//check sudoku is valid
+		pre_check();
+
+		//solve sudoku until CBJ algorithm is needed
+		pre_solve();
+
+		if (sudoku.is_solved()) {
+			return true;
+		}
+		cumulative_conflicts.assign(cumulative_conflicts.size(), Block::BLANK);
+	}
+
+	if (has_checkpoint) {
+		next_checkpoint = chrono::steady_clock::now() + checkpoint_interval;
 	}
 
 	//depth first search that uses forward checking and conflict-directed backjumping
-	unordered_map <unsigned short, unsigned short> cumulative_conflict_set;
-	cumulative_conflict_set.reserve(size*size);
-	solve_helper(cumulative_conflict_set);
+	if (variant) {
+		solve_helper<true>(cumulative_conflicts);
+	} else {
+		solve_helper<false>(cumulative_conflicts);
+	}
 
 	return sudoku.is_solved();
 }
 
 
+bool Sudoku_Solver::cage_conflict(vector<unsigned short> &cumulative_conflict_set,
+									unsigned short row, unsigned short col) const {
+	const Constraint_Model &model = sudoku.get_model();
+	unsigned short cage = model.cage_of(sudoku.get_key(row, col));
+	if (cage == Constraint_Model::NO_CAGE || sudoku.check_cage(cage)) {
+		return false;
+	}
+	//the filled blocks of the cage are what made it infeasible
+	for (auto block : model.get_cage(cage).keys) {
+		unsigned short val = sudoku.get_val((unsigned short) (block / size), (unsigned short) (block % size));
+		if (val != Block::BLANK && block != sudoku.get_key(row, col)) {
+			cumulative_conflict_set[block] = val;
+		}
+	}
+	return true;
+}
+
+
+void Sudoku_Solver::merge_conflict_set(vector<unsigned short> &cumulative_conflict_set,
+										unsigned short row, unsigned short col) const {
+	const unsigned short *cs = sudoku.get_conflict_set(row, col);
+	for (unsigned short i = 0; i < size; ++i) {
+		if (cs[i] != Block::NO_CONFLICT) {
+			cumulative_conflict_set[cs[i]] = (unsigned short) (i+1);
+		}
+	}
+}
+
+
 void Sudoku_Solver::track_row(unsigned short row) {
-	unsigned short min_col;
+	unsigned short min_col = 0;
 	size_t min_domain_size = size+1; //temporary place holder
 	for (unsigned short col = 0; col < size; ++col) {
 		if (sudoku.get_val(row, col) != Block::BLANK) {
 			continue;
 		}
-		auto new_size = sudoku.get_domain(row,col).size();
+		auto new_size = sudoku.get_domain_size(row, col);
 		if (new_size < min_domain_size) {
 			min_col = col;
 			min_domain_size = new_size;
@@ -129,6 +576,16 @@ void Sudoku_Solver::track_row(unsigned short row) {
 
 
 void Sudoku_Solver::pre_check() const {
+	const Constraint_Model &model = sudoku.get_model();
+	if (!model.is_classic()) {
+		for (size_t i = 0; i < model.get_num_units(); ++i) {
+			if (sudoku.check_unit(i) == false) {
+				throw Sudoku_Error();
+			}
+		}
+		return;
+	}
+
 	for (unsigned short i = 0; i < size; ++ i) {
 		if (sudoku.check_row(i) == false) {
 			throw Sudoku_Error();
@@ -144,35 +601,28 @@ void Sudoku_Solver::pre_check() const {
 
 
 void Sudoku_Solver::pre_solve() {
-	//update all domain
-	sudoku.update_all_domains();
+	//compute all domains and fill in every block left with a single value
+	if (sudoku.fill_singles(singles) == false) {
+		throw Sudoku_Error();
+	}
 
 	//start keeping track of blocks with minimum remaing values (min domain)
 	for (unsigned short i = 0; i < size; ++i) {
 		track_row(i);
 	}
 
-	unsigned short next = 0;
-	while (next != size) {
-		//find next block to fill (i.e. block with domain size 1)
-		for (next = 0; next < size; ++next) {
-			auto domain_size = tracker[next].second;
-			if (domain_size == 0) {
-				throw Sudoku_Error();
-			} else if (domain_size == 1) {
-				unsigned short row = next;
-				unsigned short col = tracker[next].first;
-				auto &cur_domain = sudoku.get_domain(row, col);
-				auto val_it = cur_domain.begin();
-				set_val_and_update(row, col, *val_it); //set_val, update domains and tracker
-				break;
-			}
+	//singles may have filled killer cages with the wrong sum
+	const Constraint_Model &model = sudoku.get_model();
+	for (size_t i = 0; i < model.get_num_cages(); ++i) {
+		if (sudoku.check_cage(i) == false) {
+			throw Sudoku_Error();
 		}
 	}
 }
 
 
-void Sudoku_Solver::set_val_and_update(unsigned short row, unsigned short col, unsigned short val) {
+template <>
+void Sudoku_Solver::set_val_and_update<false>(unsigned short row, unsigned short col, unsigned short val) {
 	sudoku.set_val(row, col, val);
 
 	//remove from domains in same col
@@ -206,11 +656,12 @@ void Sudoku_Solver::set_val_and_update(unsigned short row, unsigned short col, u
 
 	//remove in same square
 	//add its key to conflict_sets in same square
-	auto small_size = sudoku.get_small_size();
-	unsigned short start_row = (unsigned short) (row - row%small_size);
-	unsigned short start_col = (unsigned short) (col - col%small_size);
-	for (unsigned short i = start_row; i < start_row + small_size; ++i) {
-		for (unsigned short j = start_col; j < start_col + small_size; ++j) {
+	auto box_rows = sudoku.get_box_rows();
+	auto box_cols = sudoku.get_box_cols();
+	unsigned short start_row = (unsigned short) (row - row%box_rows);
+	unsigned short start_col = (unsigned short) (col - col%box_cols);
+	for (unsigned short i = start_row; i < start_row + box_rows; ++i) {
+		for (unsigned short j = start_col; j < start_col + box_cols; ++j) {
 			if (i == row) {
 				continue;
 			} else if (j == col) {
@@ -236,11 +687,46 @@ void Sudoku_Solver::set_val_and_update(unsigned short row, unsigned short col, u
 }
 
 
-void Sudoku_Solver::unset_val_and_update(unsigned short row, unsigned short col) {
+template <>
+void Sudoku_Solver::set_val_and_update<true>(unsigned short row, unsigned short col, unsigned short val) {
+	sudoku.set_val(row, col, val);
+
+	//remove from domains of all peers under the variant rules
+	//add its key to their conflict_sets
+	const Constraint_Model &model = sudoku.get_model();
+	unsigned short key = sudoku.get_key(row, col);
+	for (auto peer = model.peers_begin(key); peer != model.peers_end(key); ++peer) {
+		unsigned short i = (unsigned short) (*peer / size);
+		unsigned short j = (unsigned short) (*peer % size);
+		if (sudoku.get_val(i, j) != Block::BLANK) {
+			continue;
+		}
+		auto tracker_val = tracker[i].second;
+		if (sudoku.domain_erase(i, j, val)) {
+			sudoku.conflict_set_insert(i,j,row,col);
+		}
+		if (i == row) {
+			continue; //row is re-tracked below
+		}
+		auto new_size = sudoku.get_domain_size(i,j);
+		//update tracking (note domain size changes by max 1)
+		if (new_size <= tracker_val) {
+			tracker[i] = make_pair(j, new_size);
+		}
+	}
+
+	//update tracking for the row which the block val was set
+	track_row(row);
+}
+
+
+template <>
+void Sudoku_Solver::unset_val_and_update<false>(unsigned short row, unsigned short col) {
 	unsigned short val = sudoku.get_val(row, col);
 
 	//need re-tracking only if the block modified is the one in tracker
-	unordered_set<unsigned short> need_track;
+	//(bit i is set iff row i needs re-tracking, size is at most 64)
+	uint64_t need_track = 0;
 
 	//add to domains in same col
 	//delete its key to conflict_sets in same col
@@ -252,7 +738,7 @@ void Sudoku_Solver::unset_val_and_update(unsigned short row, unsigned short col)
 			sudoku.domain_insert(i, col, val);
 			if (tracker[i].first == col) {
 				//need tracking if the block pointed by the tracker is being modified
-				need_track.insert(i);
+				need_track |= uint64_t(1) << i;
 			}
 		}
 	}
@@ -267,15 +753,16 @@ void Sudoku_Solver::unset_val_and_update(unsigned short row, unsigned short col)
 			sudoku.domain_insert(row, j, val);
 		}
 	}
-	need_track.insert(row); //whole row was modified, definitely need re-tracking
+	need_track |= uint64_t(1) << row; //whole row was modified, definitely need re-tracking
 
 	//add to domains in same square
 	//delete its key to conflict_sets in same square
-	auto small_size = sudoku.get_small_size();
-	unsigned short start_row = (unsigned short) (row - row%small_size);
-	unsigned short start_col = (unsigned short) (col - col%small_size);
-	for (unsigned short i = start_row; i < start_row + small_size; ++i) {
-		for (unsigned short j = start_col; j < start_col + small_size; ++j) {
+	auto box_rows = sudoku.get_box_rows();
+	auto box_cols = sudoku.get_box_cols();
+	unsigned short start_row = (unsigned short) (row - row%box_rows);
+	unsigned short start_col = (unsigned short) (col - col%box_cols);
+	for (unsigned short i = start_row; i < start_row + box_rows; ++i) {
+		for (unsigned short j = start_col; j < start_col + box_cols; ++j) {
 			if (sudoku.get_val(i, j) != Block::BLANK) {
 				continue;
 			}
@@ -283,7 +770,7 @@ void Sudoku_Solver::unset_val_and_update(unsigned short row, unsigned short col)
 				sudoku.domain_insert(i, j, val);
 				if (tracker[i].first == j) {
 					//need tracking if the block pointed by the tracker is being modified
-					need_track.insert(i);
+					need_track |= uint64_t(1) << i;
 				}
 			}
 		}
@@ -293,8 +780,45 @@ void Sudoku_Solver::unset_val_and_update(unsigned short row, unsigned short col)
 	sudoku.set_val(row, col, Block::BLANK); //unset val to BLANK
 
 	//update tracking
-	for (auto it = need_track.begin(); it != need_track.end(); ++it) {
-		track_row(*it);
+	for (; need_track != 0; need_track &= need_track - 1) {
+		track_row((unsigned short) __builtin_ctzll(need_track));
+	}
+}
+
+
+template <>
+void Sudoku_Solver::unset_val_and_update<true>(unsigned short row, unsigned short col) {
+	unsigned short val = sudoku.get_val(row, col);
+
+	//need re-tracking only if the block modified is the one in tracker
+	//(bit i is set iff row i needs re-tracking, size is at most 64)
+	uint64_t need_track = 0;
+	need_track |= uint64_t(1) << row; //whole row was modified, definitely need re-tracking
+
+	//add to domains of all peers under the variant rules
+	//delete its key from their conflict_sets
+	const Constraint_Model &model = sudoku.get_model();
+	unsigned short key = sudoku.get_key(row, col);
+	for (auto peer = model.peers_begin(key); peer != model.peers_end(key); ++peer) {
+		unsigned short i = (unsigned short) (*peer / size);
+		unsigned short j = (unsigned short) (*peer % size);
+		if (sudoku.get_val(i, j) != Block::BLANK) {
+			continue;
+		}
+		if (sudoku.conflict_set_erase(i, j, row, col)) {
+			sudoku.domain_insert(i, j, val);
+			if (tracker[i].first == j) {
+				//need tracking if the block pointed by the tracker is being modified
+				need_track |= uint64_t(1) << i;
+			}
+		}
+	}
+
+	sudoku.set_val(row, col, Block::BLANK); //unset val to BLANK
+
+	//update tracking
+	for (; need_track != 0; need_track &= need_track - 1) {
+		track_row((unsigned short) __builtin_ctzll(need_track));
 	}
 }
 
@@ -308,3 +832,170 @@ void Sudoku_Solver::print(ostream &os) const {
 bool Sudoku_Solver::is_solved() const {
 	return sudoku.is_solved();
 }
+
+
+unsigned short Sudoku_Solver::get_val(unsigned short row, unsigned short col) const {
+	return sudoku.get_val(row, col);
+}
+
+
+unsigned short Sudoku_Solver::get_size() const {
+	return size;
+}
+
+
+void Sudoku_Solver::set_deadline(chrono::steady_clock::time_point deadline_in) {
+	deadline = deadline_in;
+	has_deadline = true;
+}
+
+
+void Sudoku_Solver::clear_deadline() {
+	has_deadline = false;
+}
+
+
+size_t Sudoku_Solver::get_node_count() const {
+	return nodes;
+}
+
+
+void Sudoku_Solver::set_recorder(Search_Recorder *recorder_in) {
+	recorder = recorder_in;
+}
+
+
+void Sudoku_Solver::set_checkpoint(const string &path_in, chrono::steady_clock::duration interval_in) {
+	checkpoint_path = path_in;
+	checkpoint_interval = interval_in;
+	has_checkpoint = true;
+}
+
+
+void Sudoku_Solver::clear_checkpoint() {
+	has_checkpoint = false;
+}
+
+
+void Sudoku_Solver::check_clock(const vector<unsigned short> &cumulative_conflict_set,
+								size_t depth) {
+	auto now = chrono::steady_clock::now();
+	if (has_deadline && now > deadline) {
+		throw Timeout_Error();
+	}
+	if (has_checkpoint && now >= next_checkpoint) {
+		save_checkpoint(cumulative_conflict_set, depth);
+		next_checkpoint = now + checkpoint_interval;
+	}
+}
+
+
+void Sudoku_Solver::save_checkpoint(const vector<unsigned short> &cumulative_conflict_set,
+									size_t depth) const {
+	string tmp_path = checkpoint_path + ".tmp";
+	{
+		ofstream out(tmp_path, ios::binary | ios::trunc);
+		unsigned char header[CHECKPOINT_HEADER_BYTES] = {};
+		memcpy(header, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+		header[4] = CHECKPOINT_VERSION;
+		header[5] = (unsigned char) sudoku.get_box_rows();
+		header[6] = (unsigned char) sudoku.get_box_cols();
+		header[7] = !sudoku.get_model().is_classic();
+		out.write((const char *) header, sizeof(header));
+
+		//the node being entered is counted again when the search resumes
+		uint64_t counts[2] = {nodes - 1, depth};
+		out.write((const char *) counts, sizeof(counts));
+		out.write((const char *) given.data(), (streamsize) (given.size() * sizeof(given[0])));
+		sudoku.write_state(out);
+		out.write((const char *) tracker.data(), (streamsize) (tracker.size() * sizeof(tracker[0])));
+		out.write((const char *) decisions.data(), (streamsize) (depth * sizeof(decisions[0])));
+		out.write((const char *) cumulative_conflict_set.data(),
+				(streamsize) (cumulative_conflict_set.size() * sizeof(cumulative_conflict_set[0])));
+		if (!out) {
+			throw Checkpoint_Error("cannot write " + tmp_path);
+		}
+	}
+	if (rename(tmp_path.c_str(), checkpoint_path.c_str()) != 0) {
+		throw Checkpoint_Error("cannot replace " + checkpoint_path);
+	}
+}
+
+
+void Sudoku_Solver::resume_from(const string &path_in) {
+	ifstream in(path_in, ios::binary);
+	if (!in.is_open()) {
+		throw Checkpoint_Error("cannot open " + path_in);
+	}
+
+	unsigned char header[CHECKPOINT_HEADER_BYTES];
+	uint64_t counts[2];
+	if (!in.read((char *) header, sizeof(header)) || memcmp(header, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC)) != 0) {
+		throw Checkpoint_Error(path_in + " is not a checkpoint");
+	} else if (header[4] != CHECKPOINT_VERSION) {
+		throw Checkpoint_Error("unsupported version " + to_string(header[4]));
+	} else if (header[5] != sudoku.get_box_rows() || header[6] != sudoku.get_box_cols()
+		|| header[7] != !sudoku.get_model().is_classic() || !in.read((char *) counts, sizeof(counts))) {
+		throw Checkpoint_Error(path_in + " was saved for a different puzzle");
+	}
+	size_t num_blocks = (size_t) size * size;
+	if (counts[1] >= num_blocks) {
+		throw Checkpoint_Error(path_in + " is corrupt");
+	}
+
+	//nothing is restored unless the checkpoint is for the board as loaded
+	in.read((char *) given.data(), (streamsize) (num_blocks * sizeof(given[0])));
+	for (unsigned short row = 0; in && row < size; ++row) {
+		for (unsigned short col = 0; col < size; ++col) {
+			if (given[sudoku.get_key(row, col)] != sudoku.get_val(row, col)) {
+				throw Checkpoint_Error(path_in + " was saved for a different puzzle");
+			}
+		}
+	}
+
+	if (!sudoku.read_state(in)) {
+		throw Checkpoint_Error(path_in + (in ? " is corrupt" : " is truncated"));
+	}
+	in.read((char *) tracker.data(), (streamsize) (tracker.size() * sizeof(tracker[0])));
+	in.read((char *) decisions.data(), (streamsize) (counts[1] * sizeof(decisions[0])));
+	in.read((char *) cumulative_conflicts.data(), (streamsize) (num_blocks * sizeof(cumulative_conflicts[0])));
+	if (!in) {
+		throw Checkpoint_Error(path_in + " is truncated");
+	}
+
+	//the search indexes with all of these, so a damaged file is refused rather than resumed
+	for (unsigned short row = 0; row < size; ++row) {
+		if (tracker[row].first >= size || tracker[row].second > size+1) {
+			throw Checkpoint_Error(path_in + " is corrupt");
+		}
+	}
+	for (size_t depth = 0; depth < counts[1]; ++depth) {
+		const Decision &decision = decisions[depth];
+		//the value on the board is the highest left in the domain, so the domain holds no value above size
+		if (decision.row >= size || decision.col >= size || decision.domain == 0
+			|| sudoku.get_val(decision.row, decision.col) != domain_last(decision.domain)) {
+			throw Checkpoint_Error(path_in + " is corrupt");
+		}
+	}
+	for (unsigned short val : cumulative_conflicts) {
+		if (val > size) {
+			throw Checkpoint_Error(path_in + " is corrupt");
+		}
+	}
+
+	nodes = counts[0];
+	resume_depth = counts[1];
+	resume_pending = true;
+	moves.clear();
+	moves_started = false;
+}
+
+
+Memory_Usage Sudoku_Solver::memory_usage() const {
+	Memory_Usage usage = sudoku.memory_usage();
+	usage.tracker = tracker.capacity() * sizeof(tracker[0]);
+	usage.search = cumulative_conflicts.capacity() * sizeof(cumulative_conflicts[0])
+		+ decisions.capacity() * sizeof(decisions[0]) + given.capacity() * sizeof(given[0])
+		+ singles.capacity() * sizeof(singles[0]);
+	return usage;
+}
@@ -5,14 +5,43 @@
 #include <vector>
 #include <utility> //pair, make_pair()
 #include <string>
-#include <unordered_set>
-#include <unordered_map>
+#include <sstream>
+#include <chrono>
 
 #include "Sudoku.h"
 
+class Search_Recorder;
+struct Node_Record;
+enum class Node_Outcome : unsigned char;
+
+//Deductions next_hint() can find, from the most to the least urgent
+enum class Hint_Technique {
+	NONE,			//no single left, the next step needs search (or a stronger technique)
+	CONTRADICTION,	//a blank block has no values left, a previous move was wrong
+	NAKED_SINGLE,	//a blank block has only one value left
+	HIDDEN_SINGLE	//a value fits only one blank block of a row, col, square (or variant unit)
+};
+
+//A next logical step found by Sudoku_Solver::next_hint()
+struct Hint {
+	Hint_Technique technique = Hint_Technique::NONE;
+	//block the step is about and the value it takes (val is BLANK for NONE and CONTRADICTION)
+	unsigned short row = 0;
+	unsigned short col = 0;
+	unsigned short val = Block::BLANK;
+	//blocks the deduction relies on, as pairs of (row, col):
+	//	NAKED_SINGLE, CONTRADICTION: one filled peer ruling out each other value
+	//	HIDDEN_SINGLE: the other blank blocks of the unit, none of which can take val
+	std::vector<std::pair<unsigned short, unsigned short> > cells;
+};
+
 //A sudoku solver that uses depth first search and
 //applys 'forward checking', 'conflict-direct backjumping'
 //and 'dynamic variable ordering' to solve any n by n sudoku
+//
+//Classic boards are propagated with hard-coded row/col/box loops; boards with
+//variant rules (see Constraint_Model) walk the model's peer table instead.
+//The search is instantiated once for each, so classic boards pay nothing for variants.
 class Sudoku_Solver {
 public:
 	//REQUIRES: istream argument satisfies the requirement for Sudoku class constructor
@@ -20,27 +49,178 @@ public:
 	//EFFECTS: create a Sudoku_Solver object
 	Sudoku_Solver(std::istream &is);
 
+	//REQUIRES: vals satisfies the requirement for Sudoku::load()
+	//MODIFIES: sudoku, size, tracker
+	//EFFECTS: create a Sudoku_Solver object from raw cell values
+	Sudoku_Solver(unsigned short small_size, const unsigned short *vals);
+
+	//REQUIRES: vals satisfies the requirement for Sudoku::load() with rectangular boxes
+	//MODIFIES: sudoku, size, tracker
+	//EFFECTS: create a Sudoku_Solver object for a board of box_rows x box_cols boxes
+	Sudoku_Solver(unsigned short box_rows, unsigned short box_cols, const unsigned short *vals);
+
+	//REQUIRES: index is smaller than archive.get_count()
+	//MODIFIES: sudoku, size, tracker
+	//EFFECTS: create a Sudoku_Solver object from board index of a binary archive
+	Sudoku_Solver(const Board_Archive &archive, size_t index);
+
+	//REQUIRES: vals satisfies the requirement for Sudoku::load()
+	//MODIFIES: sudoku, size, tracker, nodes
+	//EFFECTS: replaces the sudoku being solved, reusing the storage of the previous one
+	//		so a long-lived solver can be handed puzzle after puzzle.
+	//		Must be called before solving again after solve() threw.
+	void load(unsigned short small_size, const unsigned short *vals);
+
+	//REQUIRES: vals satisfies the requirement for Sudoku::load() with rectangular boxes
+	//MODIFIES: sudoku, size, tracker, nodes
+	//EFFECTS: same as load() above, for a board of box_rows x box_cols boxes
+	void load(unsigned short box_rows, unsigned short box_cols, const unsigned short *vals);
+
+	//REQUIRES: index is smaller than archive.get_count()
+	//MODIFIES: sudoku, size, tracker, nodes
+	//EFFECTS: same as load() above, but reads board index of a binary archive
+	void load(const Board_Archive &archive, size_t index);
+
+	//REQUIRES: no move was applied since the last load
 	//MODIFIES: sudoku, tracker
+	//EFFECTS: solves the sudoku under the variant rules of model (diagonals, jigsaw
+	//		regions, killer cages) instead of the classic rules; load() resets to classic
+	//		throws Constraint_Error() if model is for a different board size
+	void set_model(const Constraint_Model &model);
+
+	//MODIFIES: sudoku, tracker, moves
 	//EFFECTS: attempts to solve sudoku, returns true if solved
 	// 		throws Sudoku_Error() if unsolvable or if sudoku board is invalid
+	//		forgets the moves applied so far (they can no longer be undone)
 	bool solve();
 
+	//Incremental play: the domains of blank blocks are kept up to date move by move,
+	//so hints and candidates are answered without solving the board again.
+	//They are computed by the first of these calls after a load, so solvers that only
+	//solve() do not pay for them.
+
+	//REQUIRES: solve() has not been called since the last load
+	//MODIFIES: sudoku, tracker, moves, moves_started
+	//EFFECTS: fills block at (row, col) with val and removes val from its peers' domains
+	//		throws Coordinate_Error() if row or col are out of range
+	//		throws Move_Error() if the block is not blank or val is not one of its candidates
+	void apply_move(unsigned short row, unsigned short col, unsigned short val);
+
+	//MODIFIES: sudoku, tracker, moves, moves_started
+	//EFFECTS: takes back the last move applied and returns true,
+	//		returns false if there is no move to take back
+	bool undo_move();
+
+	//EFFECTS: returns the number of moves that can be taken back
+	size_t get_num_moves() const;
+
+	//MODIFIES: sudoku, tracker, moves_started (on the first call after a load)
+	//EFFECTS: returns the next logical step from the current board: the first
+	//		contradiction, else the first naked single, else the first hidden single,
+	//		else a hint with technique NONE
+	Hint next_hint();
+
+	//REQUIRES: row, col are smaller than size
+	//MODIFIES: sudoku, tracker, moves_started (on the first call after a load)
+	//EFFECTS: returns the values block at (row, col) can still take
+	//		(bit val-1 is set for each), or 0 if the block is filled
+	Domain_Mask candidates(unsigned short row, unsigned short col);
+
 	//EFFECTS: prints sudoku board to ostream
 	void print(std::ostream &os) const;
 
 	//EFFECTS: returns true iff sudoku is solved
 	bool is_solved() const;
 
+	//REQUIRES: row, col are smaller than size
+	//EFFECTS: returns value of sudoku block at (row, col)
+	unsigned short get_val(unsigned short row, unsigned short col) const;
+
+	//EFFECTS: returns the dimension of the sudoku board
+	unsigned short get_size() const;
+
+	//MODIFIES: deadline
+	//EFFECTS: makes solve() throw Timeout_Error() once the search runs past deadline_in
+	void set_deadline(std::chrono::steady_clock::time_point deadline_in);
+
+	//MODIFIES: deadline
+	//EFFECTS: lets solve() run without a time limit (the default)
+	void clear_deadline();
+
+	//EFFECTS: returns the number of search nodes visited by the last solve()
+	size_t get_node_count() const;
+
+	//MODIFIES: checkpoint settings
+	//EFFECTS: makes solve() save its search state to path_in about every interval_in,
+	//		so that a killed job can carry on with resume_from() in a new process.
+	//		Each save writes path_in.tmp and renames it over path_in, so a job killed
+	//		mid-save keeps the previous checkpoint. A save writes the board as given, the
+	//		working state (values, domains, conflict sets), the tracker, the decision path
+	//		and the cumulative conflict set, all as raw arrays in native byte order
+	//		(about 40 KB for 25x25), after a header of magic "SDKP", version, box_rows,
+	//		box_cols and whether the rules are variant.
+	//		solve() throws Checkpoint_Error() if a checkpoint cannot be written
+	void set_checkpoint(const std::string &path_in, std::chrono::steady_clock::duration interval_in);
+
+	//MODIFIES: checkpoint settings
+	//EFFECTS: stops saving checkpoints (the default)
+	void clear_checkpoint();
+
+	//REQUIRES: the sudoku was loaded from the puzzle (values and rules) the checkpoint was
+	//			saved for, and no move was applied or solve() called since
+	//MODIFIES: sudoku, tracker, nodes
+	//EFFECTS: restores the search state saved at path_in, so that the next solve()
+	//		carries on the search from where the checkpoint was saved
+	//		throws Checkpoint_Error() if the file cannot be read, is malformed, holds values,
+	//		blocks or keys out of range, or was saved for a different puzzle; the solver must
+	//		then be loaded again
+	void resume_from(const std::string &path_in);
+
+	//MODIFIES: recorder
+	//EFFECTS: records the search tree of every following solve() into recorder_in
+	//		(see Search_Recorder.h), or stops recording if recorder_in is nullptr
+	//		recorder_in must outlive its use by the solver
+	void set_recorder(Search_Recorder *recorder_in);
+
+	//EFFECTS: returns the bytes held by the sudoku's board, domains, conflict sets, the tracker
+	//		and the working state of the search
+	Memory_Usage memory_usage() const;
+
 private:
 	
+	//MODIFIES: sudoku, tracker, moves_started
+	//EFFECTS: unless already done since the last load, computes the domains of all blank
+	//		blocks from the current board and starts tracking them, so moves can be applied
+	void start_moves();
+
+	//REQUIRES: row, col are smaller than size
+	//EFFECTS: returns the first filled peer of block at (row, col) holding val,
+	//		or (size, size) if there is none
+	std::pair<unsigned short, unsigned short> find_holder(unsigned short row, unsigned short col,
+														unsigned short val) const;
+
+	//MODIFIES: hint
+	//EFFECTS: returns true and fills hint if a value fits only one blank block of a unit
+	bool find_hidden_single(Hint &hint) const;
+
 	//EFFECTS: throws Sudoku_Error() if initial sudoku block values
-	// 		have an invalid duplicate in the same row, col or sqaure
+	// 		have an invalid duplicate in the same row, col or sqaure (or variant unit)
 	void pre_check() const;
 
-	//MODIFIES: sudoku, tracker
+	//MODIFIES: tracker, cumulative_conflicts, decisions, given, singles
+	//EFFECTS: sizes the working state of the search for the board size, so that solve()
+	//		runs without allocating
+	void reserve_search();
+
+	//MODIFIES: sudoku, tracker, moves, nodes, cumulative_conflicts
+	//EFFECTS: does the work of solve()
+	bool solve_board();
+
+	//MODIFIES: sudoku, tracker, singles
 	//EFFECTS: updates domains of all empty blocks, then solves sudoku only to 
 	//		the point all values are 100% certain
 	// 		i.e. fill in sudoku blocks with domain size 1, until none of the blocks have domain size of 1
+	//		(see Sudoku::fill_singles()), then starts tracking the rows
 	//		throws Sudoku_Error() if sudoku is unsolvable (created domain size of 0 during this process)
 	void pre_solve();
 
@@ -52,6 +232,70 @@ private:
 
 	unsigned short size;
 
+	//moves: blocks filled by apply_move() as pairs of (row, col), last move at the back
+	std::vector<std::pair<unsigned short, unsigned short> > moves;
+	//moves_started: the domains and tracker are up to date for moves and hints
+	bool moves_started = false;
+
+	//nodes: number of solve_helper() calls made by the current solve()
+	size_t nodes = 0;
+
+	//the deadline and checkpoints are only checked every CLOCK_CHECK_INTERVAL nodes
+	//to keep clock reads cheap
+	static const size_t CLOCK_CHECK_INTERVAL = 1024;
+	bool has_deadline = false;
+	std::chrono::steady_clock::time_point deadline;
+
+	//A node on the search path: the block it picked and the values it has not yet
+	//searched below, the highest being the value now on the board
+	struct Decision {
+		unsigned short row;
+		unsigned short col;
+		Domain_Mask domain;
+	};
+
+	bool has_checkpoint = false;
+	std::string checkpoint_path;
+	std::chrono::steady_clock::duration checkpoint_interval;
+	std::chrono::steady_clock::time_point next_checkpoint;
+	//given: the board values before solving, so resume_from() can tell the puzzle apart
+	std::vector<unsigned short> given;
+	//decisions[depth]: decision of the node at depth on the search path, kept while checkpointing
+	std::vector<Decision> decisions;
+	//set by resume_from(): nodes shallower than resume_depth were entered before the
+	//checkpoint was saved, and the next solve() starts from the restored cumulative_conflicts
+	bool resume_pending = false;
+	size_t resume_depth = 0;
+
+	//singles: worklist of Sudoku::fill_singles(), reserved for every block of the board
+	std::vector<unsigned short> singles;
+
+	//cumulative_conflicts[key]: the value of block key in the cumulative conflict set of the
+	//search, or Block::BLANK if the block is not in it (a block is in it with one value at most)
+	std::vector<unsigned short> cumulative_conflicts;
+
+	//MODIFIES: next_checkpoint, checkpoint file
+	//EFFECTS: throws Timeout_Error() if the deadline has passed,
+	//		saves a checkpoint if one is due (see save_checkpoint())
+	void check_clock(const std::vector<unsigned short> &cumulative_conflict_set,
+					size_t depth);
+
+	//REQUIRES: the search is entering a node at depth
+	//MODIFIES: checkpoint file
+	//EFFECTS: saves the search state (see set_checkpoint())
+	//		throws Checkpoint_Error() if the file cannot be written
+	void save_checkpoint(const std::vector<unsigned short> &cumulative_conflict_set,
+						size_t depth) const;
+
+	//recorder: receives the search tree when set, a single test per node otherwise
+	Search_Recorder *recorder = nullptr;
+
+	//REQUIRES: recorder is set and returned true when the node of record was entered
+	//MODIFIES: recorder
+	//EFFECTS: completes record with outcome and the nodes visited since first_node,
+	//		and hands it to recorder
+	void leave_node(Node_Record &record, Node_Outcome outcome, size_t first_node);
+
 	//REQUIRES: row, col are smaller than size
 	//			val is non-negative and smaller or equal to size
 	//MODIFIES: tracker, value of sudoku block at (row,col),
@@ -59,6 +303,8 @@ private:
 	//EFFECTS: sets value of sudoku block at (row,col) as val
 	//			removes val from domains of blank blocks in the same row, same col, same sqaure
 	//			adds key of the block at (row,col) to the conflict_set of block which had their domain reduced
+	//			Variant = true updates every peer of the block under the variant rules instead
+	template <bool Variant>
 	void set_val_and_update(unsigned short row, unsigned short col, unsigned short val);
 
 	//REQUIRES: row, col are smaller than size
@@ -68,6 +314,8 @@ private:
 	//EFFECTS: sets value of sudoku block at (row,col) back to blank.
 	//			adds val of the block at (row,col) to domains of blank blocks in the same row,
 	// 			same col, same sqaure only if the key of the block at (row,col) is in their conflict_set
+	//			Variant = true updates every peer of the block under the variant rules instead
+	template <bool Variant>
 	void unset_val_and_update(unsigned short row, unsigned short col);
 
 	//REQUIRES: row is smaller than size
@@ -76,14 +324,31 @@ private:
 	//		whereby col indicates the index of the block at row that has the minimum domain size
 	void track_row(unsigned short row);
 
-	//REQUIRES: cumulative_conflict_set is empty
+	//REQUIRES: row, col are smaller than size
+	//MODIFIES: cumulative_conflict_set
+	//EFFECTS: adds the (key, val) pairs in the conflict set of block at (row,col)
+	//		to cumulative_conflict_set
+	void merge_conflict_set(std::vector<unsigned short> &cumulative_conflict_set,
+							unsigned short row, unsigned short col) const;
+
+	//REQUIRES: block at (row,col) is not blank
+	//MODIFIES: cumulative_conflict_set
+	//EFFECTS: returns true if the killer cage of block at (row,col) can no longer add up
+	//		to its sum, after adding the (key, val) pairs of its filled blocks
+	//		to cumulative_conflict_set; returns false if the cage is fine or there is none
+	bool cage_conflict(std::vector<unsigned short> &cumulative_conflict_set,
+						unsigned short row, unsigned short col) const;
+
+	//REQUIRES: cumulative_conflict_set is empty (all Block::BLANK)
 	//MODIFIES: cumulative_conflict_set, sudoku, tracker
 	//EFFECTS: recursively calls itself to solve the sudoku using
 	// 		depth first search that uses forward tracking and conflict-directed back jumping
 	//		returns true is sudoku is solved
 	//		returns false if found conflict or if current block's (key,val) is not in cumulative_conflict_set
 	//		throws Sudoku_Error() if sudoku is unsolvable
-	bool solve_helper(std::unordered_map<unsigned short, unsigned short>&cumulative_conflict_set, size_t depth = 0);
+	//		throws Timeout_Error() if the deadline has passed
+	template <bool Variant>
+	bool solve_helper(std::vector<unsigned short> &cumulative_conflict_set, size_t depth = 0);
 };
 
 
@@ -94,4 +359,35 @@ public:
 };
 
 
+//Expection thrown when apply_move() is given a block that is filled
+//or a value the block can no longer take
+class Move_Error {
+public:
+	Move_Error(unsigned short row, unsigned short col, unsigned short val) {
+		std::ostringstream os;
+		os << "Invalid move: value " << val << " cannot go in block (" << row << ", " << col << ").";
+		msg = os.str();
+	}
+
+	std::string msg;
+};
+
+
+//Expection thrown when a checkpoint cannot be saved or resumed
+class Checkpoint_Error {
+public:
+	Checkpoint_Error(const std::string &msg_in) : msg{"Checkpoint: " + msg_in + "\n"} {}
+
+	std::string msg;
+};
+
+
+//Expection thrown when solve() runs past the deadline given by set_deadline()
+//the solver is left mid-search and must be reloaded before it is used again
+class Timeout_Error {
+public:
+	std::string msg = "Sudoku solve timed out.";
+};
+
+
 #endif
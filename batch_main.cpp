@@ -0,0 +1,64 @@
+#include "Batch_Solver.h"
+#include "Board_Archive.h"
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+using namespace std;
+
+int main(int argc, char* argv[]) {
+	if (argc != 2 && argc != 3) {
+		cout << "Usage: " << argv[0] << " <9x9_board_archive> [<solution_archive>]\n";
+		return 1;
+	}
+
+	try {
+		Mapped_File file(argv[1]);
+		Board_Archive archive(file.data(), file.size());
+		//a 9x9 board can also have 1x9 boxes, which the batch solver does not handle
+		if (archive.get_box_rows() != 3 || archive.get_box_cols() != 3) {
+			cout << "Batch solving needs an archive of 9x9 boards with 3x3 boxes\n";
+			return 1;
+		}
+
+		size_t count = archive.get_count();
+		vector<unsigned short> vals(count * Batch_Solver::CELLS);
+		for (size_t i = 0; i < count; ++i) {
+			archive.unpack(i, vals.data() + i * Batch_Solver::CELLS);
+		}
+		vector<unsigned short> solutions(vals.size());
+		unique_ptr<bool[]> solved(new bool[count]);
+
+		Batch_Solver batch_solver;
+		auto start = chrono::steady_clock::now();
+		size_t num_solved = batch_solver.solve(vals.data(), count, solutions.data(), solved.get());
+		chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+		cout << num_solved << " of " << count << " boards solved in " << elapsed.count() << "s ("
+			<< (elapsed.count() > 0 ? (double) count / elapsed.count() : 0.0) << " boards/s)\n"
+			<< batch_solver.get_propagated_count() << " finished by propagation, "
+			<< batch_solver.get_searched_count() << " needed search\n";
+
+		if (argc == 3) {
+			//unsolvable boards are written as they were given
+			ofstream out(argv[2], ios::binary);
+			Board_Archive_Writer writer(out, 3);
+			for (size_t i = 0; i < count; ++i) {
+				const unsigned short *board = solved[i] ? solutions.data() : vals.data();
+				writer.write(board + i * Batch_Solver::CELLS);
+			}
+			writer.finish();
+		}
+	} catch (Archive_Error &err) {
+		cout << err.msg << "\n";
+		return 1;
+	} catch (Value_Error &err) {
+		cout << err.msg << "\n";
+		return 1;
+	}
+
+	return 0;
+}
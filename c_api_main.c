@@ -0,0 +1,72 @@
+#include "Sudoku_C_API.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+//Solves a board file through the C API, to show how a service embeds the solver.
+//Reads the same input files as Sudoku_Solver (classic rules only).
+int main(int argc, char* argv[]) {
+	if (argc != 2) {
+		printf("Usage: %s <sudoku_file_name>\n", argv[0]);
+		return 1;
+	}
+
+	FILE *file_in = fopen(argv[1], "r");
+	if (file_in == NULL) {
+		printf("Input file not opened\n");
+		return 1;
+	}
+
+	//box shape: n for square boxes, or rxc
+	unsigned int box_rows = 0, box_cols = 0;
+	int shape = fscanf(file_in, "%ux%u", &box_rows, &box_cols);
+	if (shape == 1) {
+		box_cols = box_rows;
+	} else if (shape != 2) {
+		printf("Bad box shape\n");
+		fclose(file_in);
+		return 1;
+	}
+
+	size_t size = (size_t) box_rows * box_cols;
+	size_t num_blocks = size * size;
+	unsigned short *cells = malloc(num_blocks * sizeof(unsigned short));
+	if (cells == NULL) {
+		fclose(file_in);
+		return 1;
+	}
+	for (size_t i = 0; i < num_blocks; ++i) {
+		unsigned int val = 0;
+		if (fscanf(file_in, "%u", &val) != 1) {
+			printf("Missing values\n");
+			free(cells);
+			fclose(file_in);
+			return 1;
+		}
+		cells[i] = (unsigned short) val;
+	}
+	fclose(file_in);
+
+	sudoku_solver *solver = sudoku_solver_create();
+	if (solver == NULL) {
+		free(cells);
+		return 1;
+	}
+	//the solution is written over the board
+	sudoku_status status = sudoku_solve(solver, (unsigned short) box_rows, (unsigned short) box_cols,
+										cells, cells);
+	if (status == SUDOKU_SOLVED) {
+		for (size_t row = 0; row < size; ++row) {
+			for (size_t col = 0; col < size; ++col) {
+				printf(col + 1 < size ? "%u " : "%u\n", (unsigned int) cells[row * size + col]);
+			}
+		}
+		printf("%llu search nodes\n", sudoku_solver_node_count(solver));
+	} else {
+		printf("%s: %s\n", sudoku_status_name(status), sudoku_solver_last_error(solver));
+	}
+
+	sudoku_solver_destroy(solver);
+	free(cells);
+	return status == SUDOKU_SOLVED ? 0 : 1;
+}
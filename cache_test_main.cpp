@@ -0,0 +1,134 @@
+#include "Solution_Cache.h"
+
+#include <cstdio> //remove()
+#include <fstream>
+#include <iostream>
+#include <iterator> //istreambuf_iterator
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//Test of loading a damaged solution cache file, run by ctest.
+//
+//A cache file holding the solution of one board is damaged in several ways; each time
+//the cache built from it must either have dropped the entry or answer a lookup of the
+//board with a miss, never with a solution that does not solve it.
+namespace {
+	const char *PUZZLE = "530070000600195000098000060800060003400803001700020006060000280000419005000080079";
+	const char *SOLUTION = "534678912672195348198342567859761423426853791713924856961537284287419635345286179";
+
+	//offsets in the file of the first entry's box shape, board and solution
+	const size_t SHAPE_POS = 8;
+	const size_t BOARD_POS = SHAPE_POS + 2;
+	const size_t SOLUTION_POS = BOARD_POS + 81;
+
+	//EFFECTS: returns the values of digits, a 9x9 board in row-major order
+	vector<unsigned short> read_board(const char *digits) {
+		vector<unsigned short> vals;
+		for (const char *c = digits; *c; ++c) {
+			vals.push_back((unsigned short) (*c - '0'));
+		}
+		return vals;
+	}
+
+	//EFFECTS: returns the contents of the file at path
+	string read_file(const string &path) {
+		ifstream is(path, ios::binary);
+		return string(istreambuf_iterator<char>(is), istreambuf_iterator<char>());
+	}
+
+	//EFFECTS: replaces the contents of the file at path with data
+	void write_file(const string &path, const string &data) {
+		ofstream os(path, ios::binary | ios::trunc);
+		os.write(data.data(), (streamsize) data.size());
+	}
+
+	//EFFECTS: loads the cache at path and looks PUZZLE up in it, returns true iff loading
+	//		throws Cache_Error(), or the lookup answers SOLUTION if expect_hit, or else misses
+	//		and leaves the cache empty; prints what went wrong otherwise
+	bool check_lookup(const string &path, const string &damage, bool expect_hit) {
+		vector<unsigned short> puzzle = read_board(PUZZLE);
+		vector<unsigned short> want = read_board(SOLUTION);
+		vector<unsigned short> got(want.size());
+		try {
+			Solution_Cache cache(1 << 20, path);
+			Canonical_Form form(3, 3, puzzle.data());
+			bool hit = cache.lookup(form, got.data());
+			if (hit && got != want) {
+				cout << "FAIL: " << damage << ": lookup answered a wrong solution\n";
+				return false;
+			} else if (hit != expect_hit) {
+				cout << "FAIL: " << damage << ": expected a " << (expect_hit ? "hit" : "miss") << "\n";
+				return false;
+			} else if (!hit && cache.get_num_entries() != 0) {
+				cout << "FAIL: " << damage << ": the damaged entry is still cached\n";
+				return false;
+			}
+		} catch (Cache_Error &err) {
+			cout << damage << ": " << err.msg; //an error is an accepted answer too
+		}
+		cout << damage << ": ok\n";
+		return true;
+	}
+}
+
+
+int main(int argc, char* argv[]) {
+	if (argc != 2) {
+		cout << "Usage: " << argv[0] << " <scratch_file>\n";
+		return 1;
+	}
+	string path = argv[1];
+	remove(path.c_str());
+
+	{
+		vector<unsigned short> puzzle = read_board(PUZZLE);
+		vector<unsigned short> solution = read_board(SOLUTION);
+		Solution_Cache cache(1 << 20, path);
+		cache.insert(Canonical_Form(3, 3, puzzle.data()), solution.data());
+	}
+	const string good = read_file(path);
+	if (good.size() != SOLUTION_POS + 81) {
+		cout << "FAIL: cache file has " << good.size() << " bytes, expected " << SOLUTION_POS + 81 << "\n";
+		return 1;
+	}
+
+	bool ok = check_lookup(path, "intact file", true);
+
+	string damaged = good;
+	damaged[SOLUTION_POS + 40] = 0;
+	write_file(path, damaged);
+	ok = check_lookup(path, "blank solution value", false) && ok;
+	if (read_file(path).size() != SHAPE_POS) {
+		cout << "FAIL: blank solution value: the damaged entry was not cut off the file\n";
+		ok = false;
+	}
+
+	damaged = good;
+	damaged[SOLUTION_POS + 40] = 10;
+	write_file(path, damaged);
+	ok = check_lookup(path, "solution value above size", false) && ok;
+
+	damaged = good;
+	damaged[BOARD_POS + 80] = 100;
+	write_file(path, damaged);
+	ok = check_lookup(path, "board value above size", false) && ok;
+
+	//in range, but the grid no longer solves the board
+	damaged = good;
+	damaged[SOLUTION_POS + 40] = (char) (damaged[SOLUTION_POS + 40] % 9 + 1);
+	write_file(path, damaged);
+	ok = check_lookup(path, "wrong solution value", false) && ok;
+
+	//a 9x9-box board is above the largest size, even with all of its bytes present
+	damaged = good.substr(0, SHAPE_POS);
+	damaged.push_back(9);
+	damaged.push_back(9);
+	damaged.append(2 * 81 * 81, 1);
+	write_file(path, damaged);
+	ok = check_lookup(path, "box shape above 64", false) && ok;
+
+	remove(path.c_str());
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,484 @@
+#include "Sudoku_Solver.h"
+#include "Allocation_Counter.h"
+
+#include <algorithm> //min(), swap()
+#include <chrono>
+#include <cstdint>
+#include <cstdlib> //getenv(), strtod()
+#include <cstring> //strcmp()
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random> //mt19937
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//Performance regression test, run by ctest once per puzzle set.
+//
+//Every set is either generated from a fixed seed or read from the sample files, so the
+//search visits the same nodes on every machine: the node count of a set must match the
+//recorded one exactly, as any change to the search heuristics (MRV tie-breaking, the
+//order of domain updates, ...) shows up there first. Wall time (fastest of TIME_RUNS runs)
+//and heap allocations (loads and solves of one run) may exceed the recorded values by
+//a margin, and solve() must not allocate at all.
+//
+//Wall time is compared in units of a calibration workload timed in the same process
+//(counting solutions of an empty board with the search of this file, which does not use
+//the solver), so a slower or busier machine scales the recorded times instead of failing.
+//
+//Recorded values are kept in perf_expected.txt; after a change that is meant to alter
+//them, rewrite it with: Sudoku_Perf <source_dir> --record
+namespace {
+	const char *EXPECTED_FILE = "perf_expected.txt";
+
+	//wall time may be this many times the recorded one, after scaling by the calibration
+	//(SUDOKU_PERF_TIME_MARGIN overrides it, e.g. on a machine with very different caches)
+	const double TIME_MARGIN = 3.0;
+	//allocations may exceed the recorded count by this share (e.g. another standard library)
+	const double ALLOCATION_MARGIN = 0.1;
+	const int TIME_RUNS = 3;
+
+	//Puzzles made by taking givens away from a shuffled full grid, in a shuffled order,
+	//until givens are left; unique keeps only removals that leave a single solution
+	//(so a set that cannot get down to givens ends up with minimal puzzles)
+	struct Generated_Set {
+		const char *name;
+		unsigned short box_rows;
+		unsigned short box_cols;
+		size_t count;
+		size_t givens;
+		bool unique;
+		uint32_t seed;
+	};
+
+	const Generated_Set GENERATED_SETS[] = {
+		{"easy_9x9", 3, 3, 4000, 36, true, 1},
+		{"hard_9x9", 3, 3, 1000, 17, true, 2},
+		{"rect_6x6", 2, 3, 10000, 8, true, 3},
+		{"rect_12x12", 3, 4, 1000, 64, false, 4},
+		{"open_16x16", 4, 4, 100, 120, false, 5}
+	};
+
+	//sample files solved in under a second, covering the variant rules
+	const char *SAMPLE_FILES[] = {
+		"sample_sudoku_1.txt", "sample_sudoku_2.txt", "sample_sudoku_3.txt", "sample_sudoku_6.txt",
+		"sample_sudoku_11_6x6.txt", "sample_sudoku_14_diagonal.txt", "sample_sudoku_15_jigsaw.txt",
+		"sample_sudoku_16_killer.txt"
+	};
+	const char *SAMPLE_SET = "samples";
+
+	//line of perf_expected.txt holding the time of the calibration workload
+	const char *CALIBRATION = "calibration";
+	//solutions of an empty 9x9 board counted by the calibration workload
+	const size_t CALIBRATION_SOLUTIONS = 50000;
+
+	//Results of running one set
+	struct Measurement {
+		size_t boards = 0;
+		size_t solved = 0;
+		uint64_t nodes = 0;
+		double ms = 0;
+		size_t allocations = 0; //by loads and solves
+		size_t solve_allocations = 0;
+	};
+
+
+	//EFFECTS: returns a number in [0:n) drawn from rng
+	//		(the standard distributions are implementation-defined, mt19937 itself is not)
+	size_t draw(mt19937 &rng, size_t n) {
+		return (size_t) (rng() % n);
+	}
+
+	//MODIFIES: order
+	//EFFECTS: shuffles order with rng, the same way on every platform
+	template <typename T>
+	void shuffle_with(vector<T> &order, mt19937 &rng) {
+		for (size_t i = order.size(); i > 1; --i) {
+			swap(order[i - 1], order[draw(rng, i)]);
+		}
+	}
+
+	//EFFECTS: returns [0:n) in an order drawn from rng
+	vector<unsigned short> shuffled(unsigned short n, mt19937 &rng) {
+		vector<unsigned short> order(n);
+		for (unsigned short i = 0; i < n; ++i) {
+			order[i] = i;
+		}
+		shuffle_with(order, rng);
+		return order;
+	}
+
+	//Counts the solutions of a classic board, for generating puzzles with a unique one
+	class Solution_Counter {
+	public:
+		Solution_Counter(unsigned short box_rows_in, unsigned short box_cols_in)
+			: box_rows{box_rows_in}, box_cols{box_cols_in}, size{(unsigned short) (box_rows_in * box_cols_in)} {}
+
+		//REQUIRES: board holds size^2 values, with no value repeated in a unit
+		//EFFECTS: returns the number of solutions of board, counting no further than limit
+		size_t count(vector<unsigned short> board, size_t limit) {
+			cells = move(board);
+			rows.assign(size, 0);
+			cols.assign(size, 0);
+			boxes.assign(size, 0);
+			for (size_t key = 0; key < cells.size(); ++key) {
+				if (cells[key] != 0) {
+					mark(key, domain_bit(cells[key]));
+				}
+			}
+			found = 0;
+			this->limit = limit;
+			search();
+			return found;
+		}
+
+	private:
+		unsigned short box_rows;
+		unsigned short box_cols;
+		unsigned short size;
+		vector<unsigned short> cells;
+		vector<Domain_Mask> rows, cols, boxes;
+		size_t found = 0;
+		size_t limit = 0;
+
+		size_t box_of(size_t key) const {
+			size_t row = key / size, col = key % size;
+			return (row / box_rows) * box_rows + col / box_cols;
+		}
+
+		//MODIFIES: rows, cols, boxes
+		//EFFECTS: flips bit in the units of block key
+		void mark(size_t key, Domain_Mask bit) {
+			rows[key / size] ^= bit;
+			cols[key % size] ^= bit;
+			boxes[box_of(key)] ^= bit;
+		}
+
+		void search() {
+			//fewest remaining values first
+			size_t best = cells.size();
+			Domain_Mask best_domain = 0;
+			unsigned short best_count = (unsigned short) (size + 1);
+			Domain_Mask full = ~Domain_Mask(0) >> (64 - size);
+			for (size_t key = 0; key < cells.size() && best_count > 1; ++key) {
+				if (cells[key] != 0) {
+					continue;
+				}
+				Domain_Mask domain = full & ~(rows[key / size] | cols[key % size] | boxes[box_of(key)]);
+				if (domain_count(domain) < best_count) {
+					best = key;
+					best_domain = domain;
+					best_count = domain_count(domain);
+				}
+			}
+			if (best == cells.size()) {
+				++found;
+				return;
+			}
+			for (; best_domain != 0 && found < limit; best_domain &= best_domain - 1) {
+				unsigned short val = domain_first(best_domain);
+				cells[best] = val;
+				mark(best, domain_bit(val));
+				search();
+				mark(best, domain_bit(val));
+				cells[best] = 0;
+			}
+		}
+	};
+
+	//EFFECTS: returns the count puzzles of set, the same on every run and platform
+	vector<vector<unsigned short> > generate(const Generated_Set &set) {
+		mt19937 rng(set.seed);
+		unsigned short box_rows = set.box_rows, box_cols = set.box_cols;
+		unsigned short size = (unsigned short) (box_rows * box_cols);
+		size_t num_blocks = (size_t) size * size;
+		Solution_Counter counter(box_rows, box_cols);
+
+		vector<vector<unsigned short> > puzzles;
+		for (size_t n = 0; n < set.count; ++n) {
+			//a valid grid, with values, bands, stacks and the rows and cols within them shuffled
+			vector<unsigned short> values = shuffled(size, rng);
+			vector<unsigned short> bands = shuffled(box_cols, rng), stacks = shuffled(box_rows, rng);
+			vector<unsigned short> row_of(size), col_of(size);
+			for (unsigned short band = 0; band < box_cols; ++band) {
+				vector<unsigned short> within = shuffled(box_rows, rng);
+				for (unsigned short i = 0; i < box_rows; ++i) {
+					row_of[band * box_rows + i] = (unsigned short) (bands[band] * box_rows + within[i]);
+				}
+			}
+			for (unsigned short stack = 0; stack < box_rows; ++stack) {
+				vector<unsigned short> within = shuffled(box_cols, rng);
+				for (unsigned short j = 0; j < box_cols; ++j) {
+					col_of[stack * box_cols + j] = (unsigned short) (stacks[stack] * box_cols + within[j]);
+				}
+			}
+			vector<unsigned short> puzzle(num_blocks);
+			for (unsigned short row = 0; row < size; ++row) {
+				for (unsigned short col = 0; col < size; ++col) {
+					unsigned short i = row_of[row], j = col_of[col];
+					unsigned short pattern = (unsigned short) ((box_cols * (i % box_rows) + i / box_rows + j) % size);
+					puzzle[(size_t) row * size + col] = (unsigned short) (values[pattern] + 1);
+				}
+			}
+
+			vector<size_t> order(num_blocks);
+			for (size_t key = 0; key < num_blocks; ++key) {
+				order[key] = key;
+			}
+			shuffle_with(order, rng);
+			size_t givens = num_blocks;
+			for (size_t key : order) {
+				if (givens <= set.givens) {
+					break;
+				}
+				unsigned short val = puzzle[key];
+				puzzle[key] = 0;
+				if (set.unique && counter.count(puzzle, 2) != 1) {
+					puzzle[key] = val;
+				} else {
+					--givens;
+				}
+			}
+			puzzles.push_back(move(puzzle));
+		}
+		return puzzles;
+	}
+
+	//MODIFIES: result
+	//EFFECTS: solves the board held by solver, adding to result
+	void solve_one(Sudoku_Solver &solver, Measurement &result) {
+		size_t allocations = Allocation_Counter::count;
+		try {
+			solver.solve();
+		} catch (Sudoku_Error &) {
+			//counted as not solved
+		}
+		result.solve_allocations += Allocation_Counter::count - allocations;
+		result.solved += solver.is_solved();
+		result.nodes += solver.get_node_count();
+		++result.boards;
+	}
+
+	//EFFECTS: runs the set once
+	Measurement run_generated(unsigned short box_rows, unsigned short box_cols,
+							const vector<vector<unsigned short> > &puzzles) {
+		Measurement result;
+		size_t allocations = Allocation_Counter::count;
+		auto start = chrono::steady_clock::now();
+		Sudoku_Solver solver(0, nullptr); //warm solver, as in Sudoku_Server
+		for (const auto &puzzle : puzzles) {
+			solver.load(box_rows, box_cols, puzzle.data());
+			solve_one(solver, result);
+		}
+		result.ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+		result.allocations = Allocation_Counter::count - allocations;
+		return result;
+	}
+
+	//EFFECTS: runs the set once
+	Measurement run_samples(const vector<string> &texts) {
+		Measurement result;
+		size_t allocations = Allocation_Counter::count;
+		auto start = chrono::steady_clock::now();
+		for (const string &text : texts) {
+			istringstream is(text);
+			Sudoku_Solver solver(is);
+			solve_one(solver, result);
+		}
+		result.ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+		result.allocations = Allocation_Counter::count - allocations;
+		return result;
+	}
+
+	//EFFECTS: runs set name TIME_RUNS times and returns the counts of the first run with
+	//		the fastest time; returns false in ok if a run counted differently from the first
+	Measurement measure(const string &source_dir, const string &name, bool &ok) {
+		vector<Measurement> runs;
+		for (const Generated_Set &set : GENERATED_SETS) {
+			if (name == set.name) {
+				vector<vector<unsigned short> > puzzles = generate(set);
+				for (int i = 0; i < TIME_RUNS; ++i) {
+					runs.push_back(run_generated(set.box_rows, set.box_cols, puzzles));
+				}
+			}
+		}
+		if (name == SAMPLE_SET) {
+			vector<string> texts;
+			for (const char *file_name : SAMPLE_FILES) {
+				ifstream file_in(source_dir + "/" + file_name);
+				if (!file_in.is_open()) {
+					cout << "Cannot open " << source_dir << "/" << file_name << "\n";
+					ok = false;
+					return Measurement();
+				}
+				ostringstream text;
+				text << file_in.rdbuf();
+				texts.push_back(text.str());
+			}
+			for (int i = 0; i < TIME_RUNS; ++i) {
+				runs.push_back(run_samples(texts));
+			}
+		}
+		if (runs.empty()) {
+			cout << "Unknown puzzle set " << name << "\n";
+			ok = false;
+			return Measurement();
+		}
+
+		Measurement result = runs[0];
+		for (const Measurement &run : runs) {
+			if (run.nodes != result.nodes || run.solved != result.solved) {
+				cout << name << ": runs of the same puzzles visited different nodes\n";
+				ok = false;
+			}
+			result.ms = min(result.ms, run.ms);
+		}
+		return result;
+	}
+
+	//EFFECTS: returns the fastest of TIME_RUNS timings of the calibration workload, in ms
+	double calibrate() {
+		double ms = 0;
+		for (int i = 0; i < TIME_RUNS; ++i) {
+			auto start = chrono::steady_clock::now();
+			Solution_Counter counter(3, 3);
+			if (counter.count(vector<unsigned short>(81, 0), CALIBRATION_SOLUTIONS) != CALIBRATION_SOLUTIONS) {
+				return 0;
+			}
+			double run = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+			ms = (i == 0) ? run : min(ms, run);
+		}
+		return ms;
+	}
+
+	//EFFECTS: returns the names of all sets
+	vector<string> set_names() {
+		vector<string> names;
+		for (const Generated_Set &set : GENERATED_SETS) {
+			names.push_back(set.name);
+		}
+		names.push_back(SAMPLE_SET);
+		return names;
+	}
+
+	//EFFECTS: reads the recorded measurements, by set name
+	map<string, Measurement> read_expected(const string &path) {
+		map<string, Measurement> expected;
+		ifstream file_in(path);
+		string line;
+		while (getline(file_in, line)) {
+			if (line.empty() || line[0] == '#') {
+				continue;
+			}
+			istringstream is(line);
+			string name;
+			Measurement measurement;
+			if (is >> name >> measurement.boards >> measurement.solved >> measurement.nodes
+				>> measurement.ms >> measurement.allocations) {
+				expected[name] = measurement;
+			}
+		}
+		return expected;
+	}
+
+	//EFFECTS: measures every set and writes the results to path, returns false on failure
+	bool record(const string &source_dir, const string &path) {
+		ostringstream out;
+		out << "# Recorded by Sudoku_Perf --record (see perf_main.cpp)\n"
+			<< "# set boards solved nodes ms allocations\n";
+		double calibration_ms = calibrate();
+		out << CALIBRATION << " 0 0 0 " << fixed << setprecision(1) << calibration_ms << " 0\n";
+		cout << CALIBRATION << ": " << calibration_ms << " ms\n";
+		for (const string &name : set_names()) {
+			bool ok = true;
+			Measurement result = measure(source_dir, name, ok);
+			if (!ok) {
+				return false;
+			}
+			out << name << " " << result.boards << " " << result.solved << " " << result.nodes << " "
+				<< fixed << setprecision(1) << result.ms << " " << result.allocations << "\n";
+			cout << name << ": " << result.nodes << " nodes, " << result.ms << " ms, "
+				<< result.allocations << " allocations\n";
+		}
+		ofstream file_out(path);
+		file_out << out.str();
+		return (bool) file_out;
+	}
+}
+
+int main(int argc, char* argv[]) {
+	if (argc != 3) {
+		cout << "Usage: " << argv[0] << " <source_dir> <puzzle_set>|--record\n"
+			<< "Puzzle sets:";
+		for (const string &name : set_names()) {
+			cout << " " << name;
+		}
+		cout << "\n";
+		return 1;
+	}
+	string source_dir = argv[1];
+	string path = source_dir + "/" + EXPECTED_FILE;
+	if (strcmp(argv[2], "--record") == 0) {
+		return record(source_dir, path) ? 0 : 1;
+	}
+
+	string name = argv[2];
+	map<string, Measurement> expected = read_expected(path);
+	if (expected.count(name) == 0) {
+		cout << "No recorded values for " << name << " in " << path << "\n";
+		return 1;
+	}
+	const Measurement &want = expected[name];
+
+	bool ok = true;
+	Measurement got = measure(source_dir, name, ok);
+	cout << name << ": " << got.boards << " boards, " << got.solved << " solved, " << got.nodes << " nodes, "
+		<< fixed << setprecision(1) << got.ms << " ms, " << got.allocations << " allocations\n";
+
+	if (got.boards != want.boards || got.solved != want.solved || got.nodes != want.nodes) {
+		cout << "FAIL: expected " << want.boards << " boards, " << want.solved << " solved, "
+			<< want.nodes << " nodes\n";
+		ok = false;
+	}
+
+	if (got.solve_allocations != 0) {
+		cout << "FAIL: solve() made " << got.solve_allocations << " allocations\n";
+		ok = false;
+	}
+	double max_allocations = (double) want.allocations * (1 + ALLOCATION_MARGIN);
+	if ((double) got.allocations > max_allocations) {
+		cout << "FAIL: more than " << max_allocations << " allocations (recorded "
+			<< want.allocations << ")\n";
+		ok = false;
+	}
+
+#ifdef NDEBUG
+	double margin = TIME_MARGIN;
+	if (const char *env = getenv("SUDOKU_PERF_TIME_MARGIN")) {
+		margin = strtod(env, nullptr);
+	}
+	//recorded times are scaled by how much slower the calibration runs now than when recorded
+	double scale = 1;
+	double calibration_ms = calibrate();
+	if (expected.count(CALIBRATION) != 0 && expected[CALIBRATION].ms > 0 && calibration_ms > 0) {
+		scale = calibration_ms / expected[CALIBRATION].ms;
+		cout << CALIBRATION << ": " << calibration_ms << " ms (recorded " << expected[CALIBRATION].ms
+			<< " ms, times scaled by " << setprecision(2) << scale << ")\n" << setprecision(1);
+	} else {
+		cout << "No calibration recorded in " << path << ", times compared unscaled\n";
+	}
+	if (got.ms > want.ms * scale * margin) {
+		cout << "FAIL: slower than " << want.ms * scale * margin << " ms (recorded " << want.ms
+			<< " ms, scale " << setprecision(2) << scale << ", margin " << setprecision(1) << margin << "x)\n";
+		ok = false;
+	}
+#else
+	cout << "Wall time not checked in builds without NDEBUG\n";
+#endif
+
+	return ok ? 0 : 1;
+}
@@ -1,17 +1,64 @@
 #include "Sudoku.h"
 #include "Sudoku_Solver.h"
+#include "Search_Recorder.h"
 
+#include <chrono>
+#include <cstdio> //remove()
+#include <cstdlib> //strtoul()
+#include <cstring> //strcmp()
 #include <fstream>
 #include <iostream>
+#include <memory>
 
 using namespace std;
 
+namespace {
+	void print_usage(const char *name) {
+		cout << "Usage: "<< name <<" <sudoku_file_name>"
+			<< " [--record <tree_dump>] [--record-depth <n>] [--record-mb <n>]"
+			<< " [--checkpoint <file>] [--checkpoint-secs <n>]\n";
+	}
+
+	//EFFECTS: writes the search tree held by recorder to path, if recorder is not nullptr
+	//		throws Record_Error() if the file cannot be written
+	void write_tree(const Search_Recorder *recorder, const char *path) {
+		if (recorder != nullptr) {
+			ofstream out(path, ios::binary);
+			recorder->write(out);
+		}
+	}
+}
+
 int main(int argc, char* argv[]) {
-	if (argc != 2) {
-		cout << "Usage: "<< argv[0] <<" <sudoku_file_name>\n";
+	if (argc < 2 || argc % 2 != 0) {
+		print_usage(argv[0]);
 		return 1;
 	}
 
+	//optional recording of the search tree (see Search_Recorder.h)
+	const char *record_path = nullptr;
+	unsigned short record_depth = Search_Recorder::NO_DEPTH_LIMIT;
+	size_t record_bytes = Search_Recorder::DEFAULT_MAX_BYTES;
+	//optional checkpoints, resumed from if the file exists (e.g. after the job was killed)
+	const char *checkpoint_path = nullptr;
+	unsigned long checkpoint_secs = 5;
+	for (int i = 2; i < argc; i += 2) {
+		if (strcmp(argv[i], "--record") == 0) {
+			record_path = argv[i+1];
+		} else if (strcmp(argv[i], "--record-depth") == 0) {
+			record_depth = (unsigned short) strtoul(argv[i+1], nullptr, 10);
+		} else if (strcmp(argv[i], "--record-mb") == 0) {
+			record_bytes = strtoul(argv[i+1], nullptr, 10) << 20;
+		} else if (strcmp(argv[i], "--checkpoint") == 0) {
+			checkpoint_path = argv[i+1];
+		} else if (strcmp(argv[i], "--checkpoint-secs") == 0) {
+			checkpoint_secs = strtoul(argv[i+1], nullptr, 10);
+		} else {
+			print_usage(argv[0]);
+			return 1;
+		}
+	}
+
 	ifstream file_in(argv[1]);
 
 	if (!file_in.is_open()) {
@@ -21,7 +68,30 @@ int main(int argc, char* argv[]) {
 
 	try {
 		Sudoku_Solver test_solver(file_in);
-		test_solver.solve();
+		unique_ptr<Search_Recorder> recorder;
+		if (record_path != nullptr) {
+			recorder.reset(new Search_Recorder(record_bytes, record_depth));
+			test_solver.set_recorder(recorder.get());
+		}
+		if (checkpoint_path != nullptr) {
+			if (ifstream(checkpoint_path).is_open()) {
+				test_solver.resume_from(checkpoint_path);
+				cerr << "Resuming from " << checkpoint_path << "\n";
+			}
+			test_solver.set_checkpoint(checkpoint_path, chrono::seconds(checkpoint_secs));
+		}
+
+		try {
+			test_solver.solve();
+		} catch (Sudoku_Error &) {
+			//the tree of a search that found no solution is written too
+			write_tree(recorder.get(), record_path);
+			throw;
+		}
+		write_tree(recorder.get(), record_path);
+		if (checkpoint_path != nullptr) {
+			remove(checkpoint_path); //the job is done
+		}
 		test_solver.print(cout);
 	} catch (Sudoku_Error &err) {
 		cout << err.msg << "\n";
@@ -32,6 +102,18 @@ int main(int argc, char* argv[]) {
 	} catch (Coordinate_Error &err) {
 		cout << err.msg << "\n";
 		return 1;
+	} catch (Size_Error &err) {
+		cout << err.msg << "\n";
+		return 1;
+	} catch (Constraint_Error &err) {
+		cout << err.msg << "\n";
+		return 1;
+	} catch (Record_Error &err) {
+		cout << err.msg << "\n";
+		return 1;
+	} catch (Checkpoint_Error &err) {
+		cout << err.msg << "\n";
+		return 1;
 	}
 
 	return 0;
@@ -0,0 +1,77 @@
+#include "Sudoku_Server.h"
+
+#include <csignal>
+#include <cstdlib> //strtoul()
+#include <cstring> //strcmp()
+#include <iostream>
+
+using namespace std;
+
+namespace {
+	Sudoku_Server *active_server = nullptr;
+
+	extern "C" void handle_signal(int) {
+		if (active_server != nullptr) {
+			active_server->stop(); //only stores to an atomic flag
+		}
+	}
+
+	void print_usage(const char *name) {
+		cout << "Usage: " << name << " (--unix <socket_path> | --tcp <port>)"
+			<< " [--workers <n>] [--queue <n>] [--timeout-ms <n>]"
+			<< " [--cache-mb <n>] [--cache-file <path>]\n";
+	}
+}
+
+int main(int argc, char* argv[]) {
+	Server_Config config;
+
+	for (int i = 1; i < argc; ++i) {
+		if (i + 1 >= argc) {
+			print_usage(argv[0]);
+			return 1;
+		}
+		const char *opt = argv[i];
+		const char *arg = argv[++i];
+		if (strcmp(opt, "--unix") == 0) {
+			config.unix_path = arg;
+		} else if (strcmp(opt, "--tcp") == 0) {
+			config.tcp_port = (unsigned short) strtoul(arg, nullptr, 10);
+		} else if (strcmp(opt, "--workers") == 0) {
+			config.num_workers = strtoul(arg, nullptr, 10);
+		} else if (strcmp(opt, "--queue") == 0) {
+			config.queue_capacity = strtoul(arg, nullptr, 10);
+		} else if (strcmp(opt, "--timeout-ms") == 0) {
+			config.timeout_ms = (unsigned int) strtoul(arg, nullptr, 10);
+		} else if (strcmp(opt, "--cache-mb") == 0) {
+			config.cache_bytes = strtoul(arg, nullptr, 10) << 20;
+		} else if (strcmp(opt, "--cache-file") == 0) {
+			config.cache_path = arg;
+		} else {
+			print_usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (config.unix_path.empty() == (config.tcp_port == 0)) {
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	try {
+		Sudoku_Server server(config);
+		active_server = &server;
+		signal(SIGINT, handle_signal);
+		signal(SIGTERM, handle_signal);
+		server.run();
+		active_server = nullptr;
+	} catch (Server_Error &err) {
+		cout << err.msg << "\n";
+		return 1;
+	} catch (Cache_Error &err) {
+		cout << err.msg << "\n";
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,195 @@
+#include "Board_Archive.h" //Mapped_File
+#include "Search_Recorder.h"
+
+#include <algorithm> //sort(), min()
+#include <cstdlib> //strtoul()
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <vector>
+
+using namespace std;
+
+namespace {
+	//a node's subtree is skipped in the costliest list when one child holds this share of it,
+	//so that the list points at where the work spreads out rather than at its ancestors
+	const double DOMINANT_CHILD_SHARE = 0.9;
+
+	const char *outcome_name(Node_Outcome outcome) {
+		switch (outcome) {
+		case Node_Outcome::SOLVED:
+			return "solved";
+		case Node_Outcome::DEAD_END:
+			return "dead end";
+		case Node_Outcome::EXHAUSTED:
+			return "exhausted";
+		case Node_Outcome::SKIPPED:
+			return "skipped";
+		}
+		return "?";
+	}
+
+	//EFFECTS: returns the values set in mask, e.g. "1,4,9"
+	string values_of(Domain_Mask mask) {
+		string out;
+		for (; mask != 0; mask &= mask - 1) {
+			if (!out.empty()) {
+				out += ",";
+			}
+			out += to_string(domain_first(mask));
+		}
+		return out.empty() ? "-" : out;
+	}
+
+	//REQUIRES: nodes are in post-order
+	//MODIFIES: largest_child
+	//EFFECTS: stores the subtree size of the largest child of every node in largest_child,
+	//		returns the indices of the nodes without a recorded parent
+	vector<size_t> link_children(const vector<Node_Record> &nodes, vector<uint64_t> &largest_child) {
+		largest_child.assign(nodes.size(), 0);
+		vector<size_t> open; //nodes whose parent has not been read yet
+		for (size_t i = 0; i < nodes.size(); ++i) {
+			//children come right before their parent, one depth deeper
+			while (!open.empty() && nodes[open.back()].depth == nodes[i].depth + 1) {
+				largest_child[i] = max(largest_child[i], nodes[open.back()].subtree_nodes);
+				open.pop_back();
+			}
+			open.push_back(i);
+		}
+		return open;
+	}
+
+	void print_costliest(const vector<Node_Record> &nodes, const vector<uint64_t> &largest_child,
+						uint64_t total, size_t count) {
+		vector<size_t> order;
+		for (size_t i = 0; i < nodes.size(); ++i) {
+			if (nodes[i].subtree_nodes > 1
+				&& (double) largest_child[i] < DOMINANT_CHILD_SHARE * (double) nodes[i].subtree_nodes) {
+				order.push_back(i);
+			}
+		}
+		sort(order.begin(), order.end(), [&nodes](size_t a, size_t b) {
+			return nodes[a].subtree_nodes > nodes[b].subtree_nodes;
+		});
+		order.resize(min(order.size(), count));
+
+		cout << "\nCostliest subtrees (where no single child holds "
+			<< (int) (DOMINANT_CHILD_SHARE * 100) << "% of the nodes):\n"
+			<< setw(7) << "depth" << setw(10) << "block" << setw(8) << "domain"
+			<< setw(12) << "nodes" << setw(8) << "share" << "  outcome, values tried\n";
+		for (size_t i : order) {
+			const Node_Record &node = nodes[i];
+			cout << setw(7) << node.depth
+				<< setw(10) << ("(" + to_string(node.row) + "," + to_string(node.col) + ")")
+				<< setw(8) << node.domain_size << setw(12) << node.subtree_nodes
+				<< setw(7) << fixed << setprecision(1) << 100.0 * (double) node.subtree_nodes / (double) total
+				<< "%  " << outcome_name(node.outcome) << ", " << values_of(node.values_tried) << "\n";
+		}
+	}
+
+	void print_jumps(const vector<Jump_Record> &jumps) {
+		cout << "\nBackjumps: " << jumps.size();
+		if (jumps.empty()) {
+			cout << "\n";
+			return;
+		}
+		map<unsigned short, size_t> by_distance;
+		size_t total_distance = 0;
+		for (const Jump_Record &jump : jumps) {
+			unsigned short distance = (unsigned short) (jump.from_depth - jump.to_depth);
+			++by_distance[distance];
+			total_distance += distance;
+		}
+		cout << ", average distance " << fixed << setprecision(2)
+			<< (double) total_distance / (double) jumps.size() << " levels"
+			<< " (1 is a chronological backtrack)\n"
+			<< setw(10) << "distance" << setw(12) << "jumps" << setw(8) << "share" << "\n";
+		for (const auto &entry : by_distance) {
+			cout << setw(10) << entry.first << setw(12) << entry.second << setw(7) << setprecision(1)
+				<< 100.0 * (double) entry.second / (double) jumps.size() << "%\n";
+		}
+	}
+
+	void print_branching(const vector<Node_Record> &nodes) {
+		struct Depth_Stats {
+			size_t nodes = 0;
+			size_t picked = 0; //nodes that picked a block with values left
+			size_t domain_sum = 0;
+			size_t children = 0;
+			size_t dead_ends = 0;
+			size_t skipped = 0;
+		};
+		map<unsigned short, Depth_Stats> by_depth;
+		for (const Node_Record &node : nodes) {
+			Depth_Stats &stats = by_depth[node.depth];
+			++stats.nodes;
+			stats.children += node.children;
+			if (node.outcome == Node_Outcome::DEAD_END) {
+				++stats.dead_ends;
+			} else {
+				++stats.picked;
+				stats.domain_sum += node.domain_size;
+			}
+			if (node.outcome == Node_Outcome::SKIPPED) {
+				++stats.skipped;
+			}
+		}
+
+		cout << "\nBranching by depth:\n"
+			<< setw(7) << "depth" << setw(12) << "nodes" << setw(9) << "domain"
+			<< setw(11) << "branching" << setw(12) << "dead ends" << setw(12) << "skipped" << "\n";
+		for (const auto &entry : by_depth) {
+			const Depth_Stats &stats = entry.second;
+			cout << setw(7) << entry.first << setw(12) << stats.nodes << fixed << setprecision(2)
+				<< setw(9) << (stats.picked ? (double) stats.domain_sum / (double) stats.picked : 0.0)
+				<< setw(11) << (double) stats.children / (double) stats.nodes
+				<< setw(12) << stats.dead_ends << setw(12) << stats.skipped << "\n";
+		}
+	}
+}
+
+int main(int argc, char* argv[]) {
+	if (argc != 2 && argc != 3) {
+		cout << "Usage: " << argv[0] << " <search_tree_dump> [<number_of_subtrees>]\n";
+		return 1;
+	}
+	size_t count = (argc == 3) ? strtoul(argv[2], nullptr, 10) : 10;
+
+	try {
+		Mapped_File file(argv[1]);
+		Search_Tree tree(file.data(), file.size());
+		const vector<Node_Record> &nodes = tree.get_nodes();
+
+		vector<uint64_t> largest_child;
+		vector<size_t> roots = link_children(nodes, largest_child);
+		uint64_t total = 0;
+		for (size_t root : roots) {
+			total += nodes[root].subtree_nodes;
+		}
+
+		cout << "Search tree of a " << tree.get_box_rows() * tree.get_box_cols() << "x"
+			<< tree.get_box_rows() * tree.get_box_cols() << " board: "
+			<< nodes.size() << " nodes recorded, " << total << " searched\n";
+		if (tree.is_truncated()) {
+			cout << "The dump hit its size cap; later nodes and jumps are missing.\n";
+		}
+		if (tree.is_incomplete()) {
+			cout << "The solve was cut short; nodes still open then are missing.\n";
+		}
+		if (nodes.empty()) {
+			return 0;
+		}
+
+		print_costliest(nodes, largest_child, total, count);
+		print_jumps(tree.get_jumps());
+		print_branching(nodes);
+	} catch (Archive_Error &err) {
+		cout << err.msg << "\n";
+		return 1;
+	} catch (Record_Error &err) {
+		cout << err.msg << "\n";
+		return 1;
+	}
+
+	return 0;
+}